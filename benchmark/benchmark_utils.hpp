@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "unpack.hpp"
+#include "unpack_deque.hpp"
 #include "random_generator.hpp"
 #include "convert_to_numeric.hpp"
 #include "add_to_any.hpp"
@@ -419,8 +420,8 @@ struct type_map {
   using vector_soa = std::vector<unpack<T>>;
   using list_aos = std::vector<T>;
   using list_soa = std::vector<unpack<T>>;
-  using deque_aos = std::vector<T>;
-  using deque_soa = std::vector<unpack<T>>;
+  using deque_aos = std::deque<T>;
+  using deque_soa = std::deque<unpack<T>>;
 };
 
 template <typename T, typename F>
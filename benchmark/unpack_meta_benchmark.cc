@@ -13,6 +13,8 @@
 // C++ standard library
 // Project sources
 #include "../include/unpack.hpp"
+#include "../include/unpack_parallel.hpp"
+#include "../include/unpack_prefetch.hpp"
 #include "unpack_meta_benchmark.hpp"
 // Third-party libraries
 #ifdef WITHGOOGLEBENCHMARK
@@ -63,6 +65,72 @@ struct looper<option::access::column>
         return std::ignore;
     }
 };
+
+// Looper structure specialization: prefetched case
+template <>
+struct looper<option::access::prefetched>
+{
+    // Execution
+    template <class F, class R, class = if_not_t<is_column_accessible, R>>
+    void operator()(F&& function, R&& range) {
+        for (auto&& x: std::forward<R>(range)) {
+            std::forward<F>(function)(std::forward<decltype(x)>(x));
+        }
+    }
+    template <class F, class R, class = if_t<is_column_accessible, R>>
+    decltype(std::ignore) operator()(F&& function, R&& range) {
+        for_each_prefetched(std::forward<R>(range), std::forward<F>(function));
+        return std::ignore;
+    }
+};
+
+// Parallel looper structure definition: row chunks
+template <option::tool, option::access>
+struct parallel_looper
+{
+    // Execution
+    template <class F, class R, class = if_not_t<is_column_accessible, R>>
+    void operator()(F&& function, R&& range) {
+        const std::size_t size = std::forward<R>(range).size();
+        const std::size_t threads = unpack_default_threads();
+        auto first = std::begin(std::forward<R>(range));
+        parallel_run(threads, threads, [&](std::size_t i) {
+            auto last = first + size * (i + 1) / threads;
+            for (auto it = first + size * i / threads; it != last; ++it) {
+                std::forward<F>(function)(*it);
+            }
+        });
+    }
+    template <class F, class R, class = if_t<is_column_accessible, R>>
+    decltype(std::ignore) operator()(F&& function, R&& range) {
+        parallel_for_each(std::forward<R>(range), std::forward<F>(function));
+        return std::ignore;
+    }
+};
+
+// Parallel looper structure specialization: one task per column group
+template <>
+struct parallel_looper<option::tool::parallel_columns, option::access::independent>
+{
+    // Types
+    using fallback_type = parallel_looper<
+        option::tool::parallel_rows,
+        option::access::independent
+    >;
+
+    // Execution
+    template <class F, class R, class = if_not_t<is_column_accessible, R>>
+    void operator()(F&& function, R&& range) {
+        fallback_type()(std::forward<F>(function), std::forward<R>(range));
+    }
+    template <class F, class R, class = if_t<is_column_accessible, R>>
+    decltype(std::ignore) operator()(F&& function, R&& range) {
+        parallel_for_each_column(std::forward<R>(range), [&function](auto& x) {
+            std::forward<F>(function)(std::tie(x));
+        });
+        return std::ignore;
+    }
+};
 /* ************************************************************************** */
 
 
@@ -125,6 +193,58 @@ struct benchmarker<option::tool::chrono, Access>
     }
 };
 
+// Benchmarker structure definition: parallel rows specialization
+template <option::access Access>
+struct benchmarker<option::tool::parallel_rows, Access>
+{
+    // Benchmark
+    template <class F, class R, class M>
+    double operator()(F&& function, R&& range, M&& measurements) {
+        using looper_type = parallel_looper<option::tool::parallel_rows, Access>;
+        using clock_type = std::chrono::steady_clock;
+        using duration_type = std::chrono::duration<double>;
+        typename clock_type::time_point tbegin;
+        typename clock_type::time_point tend;
+        typename clock_type::time_point t0;
+        typename clock_type::time_point t1;
+        tbegin = clock_type::now();
+        for (auto&& m: std::forward<M>(measurements)) {
+            t0 = clock_type::now();
+            looper_type()(std::forward<F>(function), std::forward<R>(range));
+            t1 = clock_type::now();
+            m = std::chrono::duration_cast<duration_type>(t1 - t0).count();
+        }
+        tend = clock_type::now();
+        return std::chrono::duration_cast<duration_type>(tend - tbegin).count();
+    }
+};
+
+// Benchmarker structure definition: parallel columns specialization
+template <option::access Access>
+struct benchmarker<option::tool::parallel_columns, Access>
+{
+    // Benchmark
+    template <class F, class R, class M>
+    double operator()(F&& function, R&& range, M&& measurements) {
+        using looper_type = parallel_looper<option::tool::parallel_columns, Access>;
+        using clock_type = std::chrono::steady_clock;
+        using duration_type = std::chrono::duration<double>;
+        typename clock_type::time_point tbegin;
+        typename clock_type::time_point tend;
+        typename clock_type::time_point t0;
+        typename clock_type::time_point t1;
+        tbegin = clock_type::now();
+        for (auto&& m: std::forward<M>(measurements)) {
+            t0 = clock_type::now();
+            looper_type()(std::forward<F>(function), std::forward<R>(range));
+            t1 = clock_type::now();
+            m = std::chrono::duration_cast<duration_type>(t1 - t0).count();
+        }
+        tend = clock_type::now();
+        return std::chrono::duration_cast<duration_type>(tend - tbegin).count();
+    }
+};
+
 // Benchmarker structure definition: google specialization
 template <option::access Access>
 struct benchmarker<option::tool::google, Access>
@@ -150,6 +270,34 @@ struct benchmarker<option::tool::googles, Access>
 
 
 
+/* ****************************  CONTAINER MAKER **************************** */
+// Container maker structure definition: value-initialized elements
+template <class C, class = void>
+struct container_maker
+{
+    // Construction
+    C operator()(std::size_t size) const {
+        return C(size);
+    }
+};
+
+// Container maker structure specialization: default-initialized elements,
+// as the initializer overwrites every element anyway
+template <class C>
+struct container_maker<
+    C,
+    void_t<decltype(C(std::size_t(), unpack_default_init))>
+>
+{
+    // Construction
+    C operator()(std::size_t size) const {
+        return C(size, unpack_default_init);
+    }
+};
+/* ************************************************************************** */
+
+
+
 /* *******************************  EXECUTOR ******************************** */
 // Executor structure definition
 template <
@@ -195,7 +343,7 @@ struct executor
             invoker_t()(operation_t(), std::forward<decltype(x)>(x));
         };
         benchmaker_t benchmark;
-        container_t container(size);
+        container_t container = container_maker<container_t>()(size);
         initializer(container);
         timing = benchmark(function, container, measurements);
         finalizer(container);
@@ -236,12 +384,16 @@ struct program
             option::tool::system,
             option::tool::chrono,
             option::tool::google,
-            option::tool::googles
+            option::tool::googles,
+            option::tool::parallel_rows,
+            option::tool::parallel_columns
         >,
         option_selector<
             option::tool,
             option::tool::system,
-            option::tool::chrono
+            option::tool::chrono,
+            option::tool::parallel_rows,
+            option::tool::parallel_columns
         >
     >::type;
     using orientation_selector_t = option_selector<
@@ -313,7 +465,8 @@ struct program
         option::access::single,
         option::access::independent,
         option::access::combined,
-        option::access::column
+        option::access::column,
+        option::access::prefetched
     >;
     
     // Lifecycle
@@ -829,12 +829,12 @@ struct byte_checker
 // Option structure definition
 struct option
 {
-    enum struct tool {system, chrono, google, googles};
+    enum struct tool {system, chrono, google, googles, parallel_rows, parallel_columns};
     enum struct orientation {aos, soa};
     enum struct container {vector};
     enum struct type {};
     enum struct complexity {simple, complex, branching};
-    enum struct access {single, independent, combined, column};
+    enum struct access {single, independent, combined, column, prefetched};
 };
 
 // Option type name structure declaration
@@ -915,6 +915,20 @@ struct option_name<option::tool, option::tool::googles>
     static constexpr auto value = "googles";
 };
 
+// Option name structure definition: parallel rows specialization
+template <>
+struct option_name<option::tool, option::tool::parallel_rows>
+{
+    static constexpr auto value = "parallel_rows";
+};
+
+// Option name structure definition: parallel columns specialization
+template <>
+struct option_name<option::tool, option::tool::parallel_columns>
+{
+    static constexpr auto value = "parallel_columns";
+};
+
 // Option name structure definition: aos specialization
 template <>
 struct option_name<option::orientation, option::orientation::aos>
@@ -985,6 +999,13 @@ struct option_name<option::access, option::access::column>
     static constexpr auto value = "column";
 };
 
+// Option name structure definition: prefetched specialization
+template <>
+struct option_name<option::access, option::access::prefetched>
+{
+    static constexpr auto value = "prefetched";
+};
+
 // Option type structure definition
 template <class Type, Type Value>
 struct option_type
@@ -1415,6 +1436,13 @@ struct invoker<option::access::column>
         std::forward<F>(f)(std::forward<T>(x));
     }
 };
+
+// Invoker structure declaration: prefetched specialization
+template <>
+struct invoker<option::access::prefetched>
+: invoker<option::access::combined>
+{
+};
 /* ************************************************************************** */
 
 
@@ -0,0 +1,420 @@
+#ifndef UNPACK_ARCHETYPE
+#define UNPACK_ARCHETYPE
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "unpack_slot_map.hpp"
+#include "unpack_vector.hpp"
+
+// A set of component types. The entities of an archetype_store holding
+// exactly these components are stored together, one column per component.
+template <typename ... Components>
+struct archetype {};
+
+constexpr bool unpack_all_of(std::initializer_list<bool> values) {
+  for (bool value : values) {
+    if (!value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Position of the first true value, or the number of values if none is.
+constexpr std::size_t unpack_find_first(std::initializer_list<bool> values) {
+  std::size_t i = 0;
+  for (bool value : values) {
+    if (value) {
+      return i;
+    }
+    i++;
+  }
+  return i;
+}
+
+template <typename C, typename A>
+struct archetype_index_of;
+
+template <typename C, typename ... Components>
+struct archetype_index_of<C, archetype<Components ...>> {
+  static constexpr std::size_t value = unpack_find_first({ std::is_same<C, Components>::value ... });
+};
+
+template <typename C, typename A>
+struct archetype_contains;
+
+template <typename C, typename ... Components>
+struct archetype_contains<C, archetype<Components ...>> {
+  static constexpr bool value = archetype_index_of<C, archetype<Components ...>>::value
+    < sizeof...(Components);
+};
+
+template <typename A, typename B>
+struct archetype_subset;
+
+template <typename ... Components, typename B>
+struct archetype_subset<archetype<Components ...>, B> {
+  static constexpr bool value = unpack_all_of({ archetype_contains<Components, B>::value ... });
+};
+
+template <typename A>
+struct archetype_size;
+
+template <typename ... Components>
+struct archetype_size<archetype<Components ...>> {
+  static constexpr std::size_t value = sizeof...(Components);
+};
+
+// Whether To holds the components of From plus C.
+template <typename C, typename From, typename To>
+struct archetype_adds {
+  static constexpr bool value = archetype_contains<C, To>::value
+    && archetype_subset<From, To>::value
+    && archetype_size<To>::value == archetype_size<From>::value
+      + !archetype_contains<C, From>::value;
+};
+
+// Whether To holds the components of From but C.
+template <typename C, typename From, typename To>
+struct archetype_removes {
+  static constexpr bool value = !archetype_contains<C, To>::value
+    && archetype_subset<To, From>::value
+    && archetype_size<To>::value + archetype_contains<C, From>::value
+      == archetype_size<From>::value;
+};
+
+// The rows of one archetype and the entity of each row.
+template <typename A>
+struct archetype_table;
+
+template <typename ... Components>
+struct archetype_table<archetype<Components ...>> {
+  using row_type = std::tuple<Components ...>;
+
+  std::vector<unpack<row_type>> rows;
+  std::vector<unpack_handle> entities;
+
+  template <typename C>
+  C* column() {
+    return rows.template data<archetype_index_of<C, archetype<Components ...>>::value>();
+  }
+};
+
+// Entities made of components, stored by archetype: every archetype the
+// store is declared with gets its own vector<unpack<T>> of the components
+// it holds, so a loop over a few components of many entities reads only
+// those columns. Adding or removing a component moves the entity to the
+// declared archetype with the resulting set of components, which must
+// exist. Entities are named by generational handles as in slot_map; rows
+// are moved between and within tables, so handles are the only stable
+// reference to an entity.
+template <typename ... Archetypes>
+class archetype_store {
+  private:
+    using tables_type = std::tuple<archetype_table<Archetypes> ...>;
+    using Indices = std::make_index_sequence<sizeof...(Archetypes)>;
+
+    static constexpr std::size_t no_archetype = sizeof...(Archetypes);
+    static constexpr std::uint32_t no_slot = std::uint32_t(-1);
+
+    struct slot {
+      std::uint32_t archetype;
+      // Row of a live entity, or the next free slot of a free one.
+      std::uint32_t index;
+      std::uint32_t generation;
+    };
+
+    tables_type _tables;
+    std::vector<slot> _slots;
+    std::uint32_t _free;
+    std::size_t _size;
+
+    template <typename A>
+    static constexpr std::size_t archetype_id() {
+      return unpack_find_first({ std::is_same<A, Archetypes>::value ... });
+    }
+
+    template <typename C, typename From>
+    static constexpr std::size_t added_id() {
+      return unpack_find_first({ archetype_adds<C, From, Archetypes>::value ... });
+    }
+
+    template <typename C, typename From>
+    static constexpr std::size_t removed_id() {
+      return unpack_find_first({ archetype_removes<C, From, Archetypes>::value ... });
+    }
+
+    template <std::size_t I>
+    using archetype_at = typename std::tuple_element<I, std::tuple<Archetypes ...>>::type;
+
+    // Calls f(std::integral_constant<std::size_t, I>) for archetype I = id.
+    template <typename F, std::size_t ... I>
+    static void visit(std::size_t id, F&& f, std::index_sequence<I ...>) {
+      using dummy = int[];
+      (void)dummy{0, (id == I ? (f(std::integral_constant<std::size_t, I>()), 0) : 0) ...};
+    }
+
+    template <typename F>
+    static void visit(std::size_t id, F&& f) {
+      visit(id, std::forward<F>(f), Indices());
+    }
+
+    const slot& live_slot(unpack_handle entity) const {
+      if (!contains(entity)) {
+        throw std::out_of_range("archetype_store: stale entity");
+      }
+      return _slots[entity.slot];
+    }
+
+    // Component C of a row of another archetype, or a value-initialized C
+    // if the row has none.
+    template <typename C, typename A, typename Row>
+    static C component_of(const Row& row, std::true_type) {
+      return std::get<archetype_index_of<C, A>::value>(row);
+    }
+
+    template <typename C, typename A, typename Row>
+    static C component_of(const Row&, std::false_type) {
+      return C();
+    }
+
+    // Appends the row of entity to table To, taking the components both
+    // archetypes have and value-initializing the others.
+    template <std::size_t To, typename From, typename Row, std::size_t ... I>
+    void append_converted(const Row& row, unpack_handle entity, std::index_sequence<I ...>) {
+      using row_type = typename archetype_table<archetype_at<To>>::row_type;
+      auto& table = std::get<To>(_tables);
+      table.rows.push_back(row_type(component_of<
+          typename std::tuple_element<I, row_type>::type, From>(row,
+            std::integral_constant<bool, archetype_contains<
+              typename std::tuple_element<I, row_type>::type, From>::value>()) ...));
+      try {
+        table.entities.push_back(entity);
+      } catch (...) {
+        table.rows.pop_back();
+        throw;
+      }
+    }
+
+    // Removes row index of archetype id, moving the last row into it.
+    void remove_row(std::size_t id, std::uint32_t index) {
+      visit(id, [this, index](auto a) {
+        auto& table = std::get<decltype(a)::value>(_tables);
+        std::uint32_t last = static_cast<std::uint32_t>(table.rows.size() - 1);
+        if (index != last) {
+          table.rows[index] = table.rows[last];
+          table.entities[index] = table.entities[last];
+          _slots[table.entities[index].slot].index = index;
+        }
+        table.rows.pop_back();
+        table.entities.pop_back();
+      });
+    }
+
+    // Moves entity from its archetype to archetype To.
+    template <std::size_t To>
+    void migrate(unpack_handle entity) {
+      slot& s = _slots[entity.slot];
+      if (s.archetype == To) {
+        return;
+      }
+      std::size_t from = s.archetype;
+      std::uint32_t index = s.index;
+      visit(from, [this, entity, index](auto a) {
+        using From = archetype_at<decltype(a)::value>;
+        auto& table = std::get<decltype(a)::value>(_tables);
+        append_converted<To, From>(table.rows[index], entity,
+            std::make_index_sequence<archetype_size<archetype_at<To>>::value>());
+      });
+      remove_row(from, index);
+      s.archetype = To;
+      s.index = static_cast<std::uint32_t>(std::get<To>(_tables).rows.size() - 1);
+    }
+
+    template <std::size_t To>
+    void migrate_or_throw(unpack_handle entity, std::true_type) {
+      migrate<To>(entity);
+    }
+
+    template <std::size_t To>
+    void migrate_or_throw(unpack_handle, std::false_type) {
+      throw std::logic_error("archetype_store: no archetype with the resulting components");
+    }
+
+  public:
+    archetype_store() : _free(no_slot), _size(0) {}
+
+    // Creates an entity of archetype A with the given components, in the
+    // order A lists them.
+    template <typename A, typename ... Components>
+    unpack_handle create(Components&& ... components) {
+      constexpr std::size_t id = archetype_id<A>();
+      static_assert(id < no_archetype, "archetype_store: undeclared archetype");
+      auto& table = std::get<id>(_tables);
+      table.rows.emplace_back(std::forward<Components>(components) ...);
+      std::uint32_t s = _free;
+      try {
+        if (s == no_slot) {
+          if (_slots.size() == no_slot) {
+            throw std::length_error("archetype_store: out of slots");
+          }
+          s = static_cast<std::uint32_t>(_slots.size());
+          _slots.push_back(slot{ static_cast<std::uint32_t>(no_archetype), 0, 0 });
+        }
+        table.entities.push_back(unpack_handle{ s, _slots[s].generation });
+      } catch (...) {
+        table.rows.pop_back();
+        throw;
+      }
+      if (s == _free) {
+        _free = _slots[s].index;
+      }
+      _slots[s].archetype = static_cast<std::uint32_t>(id);
+      _slots[s].index = static_cast<std::uint32_t>(table.rows.size() - 1);
+      _size++;
+      return table.entities.back();
+    }
+
+    bool contains(unpack_handle entity) const {
+      return entity.slot < _slots.size() && _slots[entity.slot].generation == entity.generation
+        && _slots[entity.slot].archetype != no_archetype;
+    }
+
+    // Throws std::out_of_range if entity was destroyed.
+    void destroy(unpack_handle entity) {
+      slot s = live_slot(entity);
+      remove_row(s.archetype, s.index);
+      slot& freed = _slots[entity.slot];
+      freed.archetype = static_cast<std::uint32_t>(no_archetype);
+      freed.generation++;
+      freed.index = _free;
+      _free = entity.slot;
+      _size--;
+    }
+
+    template <typename C>
+    bool has(unpack_handle entity) const {
+      bool found = false;
+      visit(live_slot(entity).archetype, [&found](auto a) {
+        found = archetype_contains<C, archetype_at<decltype(a)::value>>::value;
+      });
+      return found;
+    }
+
+    // Component C of entity. Throws std::out_of_range if entity was
+    // destroyed or has no C.
+    template <typename C>
+    C& get(unpack_handle entity) {
+      const slot& s = live_slot(entity);
+      C* component = nullptr;
+      std::uint32_t index = s.index;
+      visit(s.archetype, [this, &component, index](auto a) {
+        component = column_of<C>(std::get<decltype(a)::value>(_tables),
+            std::integral_constant<bool, archetype_contains<C,
+              archetype_at<decltype(a)::value>>::value>());
+        if (component) {
+          component += index;
+        }
+      });
+      if (!component) {
+        throw std::out_of_range("archetype_store: entity has no such component");
+      }
+      return *component;
+    }
+
+    // Gives entity component C, moving it to the archetype with its
+    // components plus C, or sets C if it has one already. Throws
+    // std::logic_error if no such archetype was declared.
+    template <typename C>
+    void add(unpack_handle entity, const C& component) {
+      visit(live_slot(entity).archetype, [this, entity](auto a) {
+        constexpr std::size_t to = added_id<C, archetype_at<decltype(a)::value>>();
+        this->template migrate_or_throw<(to < no_archetype ? to : 0)>(entity,
+            std::integral_constant<bool, (to < no_archetype)>());
+      });
+      get<C>(entity) = component;
+    }
+
+    // Takes component C from entity, moving it to the archetype with its
+    // components but C. Throws std::logic_error if no such archetype was
+    // declared.
+    template <typename C>
+    void remove(unpack_handle entity) {
+      visit(live_slot(entity).archetype, [this, entity](auto a) {
+        constexpr std::size_t to = removed_id<C, archetype_at<decltype(a)::value>>();
+        this->template migrate_or_throw<(to < no_archetype ? to : 0)>(entity,
+            std::integral_constant<bool, (to < no_archetype)>());
+      });
+    }
+
+    // Live entities.
+    std::size_t size() const {
+      return _size;
+    }
+
+    bool empty() const {
+      return _size == 0;
+    }
+
+    // Rows of archetype A.
+    template <typename A>
+    const std::vector<unpack<typename archetype_table<A>::row_type>>& rows() const {
+      return std::get<archetype_id<A>()>(_tables).rows;
+    }
+
+    // Calls f(columns ..., rows) for every archetype holding all of
+    // Components, with the columns of exactly those components.
+    template <typename ... Components, typename F>
+    void for_each_chunk(F&& f) {
+      for_each_chunk_helper<Components ...>(f, Indices());
+    }
+
+    // Calls f(components ...) for every entity holding all of Components.
+    template <typename ... Components, typename F>
+    void for_each(F&& f) {
+      for_each_chunk<Components ...>([&f](Components* ... columns, std::size_t rows) {
+        for (std::size_t i = 0; i < rows; i++) {
+          f(columns[i] ...);
+        }
+      });
+    }
+
+  private:
+    template <typename C, typename Table>
+    static C* column_of(Table& table, std::true_type) {
+      return table.template column<C>();
+    }
+
+    template <typename C, typename Table>
+    static C* column_of(Table&, std::false_type) {
+      return nullptr;
+    }
+
+    template <typename ... Components, typename F, typename Table>
+    static void call_chunk(F& f, Table& table, std::true_type) {
+      if (!table.rows.empty()) {
+        f(table.template column<Components>() ..., table.rows.size());
+      }
+    }
+
+    template <typename ... Components, typename F, typename Table>
+    static void call_chunk(F&, Table&, std::false_type) {
+    }
+
+    template <typename ... Components, typename F, std::size_t ... I>
+    void for_each_chunk_helper(F& f, std::index_sequence<I ...>) {
+      using dummy = int[];
+      (void)dummy{0, (call_chunk<Components ...>(f, std::get<I>(_tables),
+            std::integral_constant<bool, archetype_subset<archetype<Components ...>,
+              archetype_at<I>>::value>()), 0) ...};
+    }
+};
+
+#endif
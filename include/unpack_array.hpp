@@ -0,0 +1,198 @@
+#ifndef UNPACK_ARRAY
+#define UNPACK_ARRAY
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include "unpack_iterator.hpp"
+#include "unpack_details.hpp"
+#include "unpack_expression.hpp"
+
+template <typename T, std::size_t N, typename Indices>
+struct array_inversion_helper;
+
+template <typename T, std::size_t N, std::size_t ... Indices>
+struct array_inversion_helper<T, N, std::index_sequence<Indices ...>> {
+  using type = std::tuple<std::array<typename std::tuple_element<Indices, T>::type, N> ...>;
+  using iter_type = std::tuple<
+    typename std::array<typename std::tuple_element<Indices, T>::type, N>::iterator ...>;
+  using const_iter_type = std::tuple<
+    typename std::array<typename std::tuple_element<Indices, T>::type, N>::const_iterator ...>;
+};
+
+template <typename T, std::size_t N>
+struct unpack_array_inversion {
+  using Indices = std::make_index_sequence<std::tuple_size<T>::value>;
+  using type = typename array_inversion_helper<T, N, Indices>::type;
+  using iter_type = typename array_inversion_helper<T, N, Indices>::iter_type;
+  using const_iter_type = typename array_inversion_helper<T, N, Indices>::const_iter_type;
+};
+
+namespace std
+{
+
+// Fixed size counterpart of vector<unpack<T>>: one std::array<Ti, N> per
+// column, stored inline. As with std::array, elements are default
+// initialized unless the array is value-initialized (array<...> a{}).
+// Column loops over data<I>() run to the compile time constant size(), so
+// the compiler can unroll and vectorize them completely.
+template <typename T, size_t N>
+class array<unpack<T>, N> {
+  private:
+    using data_type = typename unpack_array_inversion<T, N>::type;
+    using tuple_refs_type = typename unpack_tuple_refs_type<T>::type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+    data_type _data;
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = unpack_iterator<typename unpack_array_inversion<T, N>::iter_type>;
+    using const_iterator = unpack_const_iterator<
+      typename unpack_array_inversion<T, N>::const_iter_type>;
+
+    static constexpr size_t size() {
+      return N;
+    }
+
+    static constexpr size_t max_size() {
+      return N;
+    }
+
+    static constexpr bool empty() {
+      return N == 0;
+    }
+
+    void fill(const T& value) {
+      tuple_for_each([](auto& cur_array, auto& cur_elem) {
+        cur_array.fill(cur_elem);
+      }, _data, value);
+    }
+
+    void swap(array<unpack<T>, N>& a) {
+      tuple_for_each([](auto& cur_array, auto& target_cur_array) {
+        cur_array.swap(target_cur_array);
+      }, _data, a._data);
+    }
+
+    tuple_refs_type operator[](size_t index) {
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_const_refs_type operator[](size_t index) const {
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_refs_type at(size_t index) {
+      throw_if_out_of_bounds(index, N);
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_const_refs_type at(size_t index) const {
+      throw_if_out_of_bounds(index, N);
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_refs_type front() {
+      return operator[](0);
+    }
+
+    tuple_const_refs_type front() const {
+      return operator[](0);
+    }
+
+    tuple_refs_type back() {
+      return operator[](N - 1);
+    }
+
+    tuple_const_refs_type back() const {
+      return operator[](N - 1);
+    }
+
+    template <size_t I>
+    auto data() {
+      return std::get<I>(_data).data();
+    }
+
+    template <size_t I>
+    auto data() const {
+      return std::get<I>(_data).data();
+    }
+
+    // Column I as an operand of lazy column expressions, see vector::col.
+    template <size_t I>
+    auto col() {
+      return unpack_column<typename std::tuple_element<I, T>::type>(data<I>(), N);
+    }
+
+    template <size_t I>
+    auto col() const {
+      return unpack_column<const typename std::tuple_element<I, T>::type>(data<I>(), N);
+    }
+
+    iterator begin() {
+      return iterator(make_tuple_vec_iter(_data, [](auto& cur_array) {
+            return cur_array.begin(); }));
+    }
+
+    iterator end() {
+      return iterator(make_tuple_vec_iter(_data, [](auto& cur_array) {
+            return cur_array.end(); }));
+    }
+
+    const_iterator begin() const {
+      return const_iterator(make_tuple_vec_const_iter(_data, [](auto& cur_array) {
+            return cur_array.cbegin(); }));
+    }
+
+    const_iterator end() const {
+      return const_iterator(make_tuple_vec_const_iter(_data, [](auto& cur_array) {
+            return cur_array.cend(); }));
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+    template <size_t I>
+    auto begin() {
+      return std::get<I>(_data).begin();
+    }
+
+    template <size_t I>
+    auto end() {
+      return std::get<I>(_data).end();
+    }
+
+    template <size_t I>
+    auto begin() const {
+      return std::get<I>(_data).cbegin();
+    }
+
+    template <size_t I>
+    auto end() const {
+      return std::get<I>(_data).cend();
+    }
+
+    friend bool operator==(const array<unpack<T>, N>& lhs, const array<unpack<T>, N>& rhs) {
+      return lhs._data == rhs._data;
+    }
+
+    friend bool operator!=(const array<unpack<T>, N>& lhs, const array<unpack<T>, N>& rhs) {
+      return !(lhs == rhs);
+    }
+
+    friend void swap(array<unpack<T>, N>& lhs, array<unpack<T>, N>& rhs) {
+      lhs.swap(rhs);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,858 @@
+#ifndef UNPACK_ARROW
+#define UNPACK_ARROW
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "unpack_vector.hpp"
+
+// Arrow IPC (file and stream format) export/import for std::vector<unpack<T>>.
+// The flatbuffer metadata is encoded by hand so no Arrow or flatbuffers
+// library is needed. Only little-endian hosts are supported, which is also
+// the only byte order the exported schema advertises.
+
+enum class arrow_type_id : std::uint8_t {
+  none = 0, int_ = 2, floating_point = 3, utf8 = 5
+};
+
+struct arrow_field {
+  std::string name;
+  arrow_type_id type = arrow_type_id::none;
+  std::int32_t bit_width = 0;
+  bool is_signed = false;
+  std::int16_t precision = 0;
+};
+
+// Minimal back-to-front flatbuffer builder. Objects are prepended, so every
+// child has to be created before the table that refers to it. Offsets
+// returned by the builder are measured from the end of the buffer.
+class arrow_flatbuffer_builder {
+  private:
+    std::vector<unsigned char> _buf;
+    std::size_t _minalign = 1;
+    std::uint32_t _table_start = 0;
+    std::vector<std::pair<std::uint16_t, std::uint32_t>> _fields;
+
+    void prepend(const void* bytes, std::size_t n) {
+      auto first = static_cast<const unsigned char*>(bytes);
+      _buf.insert(_buf.begin(), first, first + n);
+    }
+
+    // pad so that the next n bytes end on an alignment boundary
+    void align(std::size_t n, std::size_t alignment) {
+      if (alignment > _minalign) {
+        _minalign = alignment;
+      }
+      std::size_t pad = (alignment - (_buf.size() + n) % alignment) % alignment;
+      _buf.insert(_buf.begin(), pad, 0);
+    }
+
+  public:
+    std::uint32_t size() const {
+      return static_cast<std::uint32_t>(_buf.size());
+    }
+
+    template <typename S>
+    std::uint32_t push(S value) {
+      align(sizeof(S), sizeof(S));
+      prepend(&value, sizeof(S));
+      return size();
+    }
+
+    std::uint32_t push_offset(std::uint32_t target) {
+      align(sizeof(std::uint32_t), sizeof(std::uint32_t));
+      std::uint32_t relative = size() + sizeof(std::uint32_t) - target;
+      prepend(&relative, sizeof(relative));
+      return size();
+    }
+
+    std::uint32_t create_string(const std::string& s) {
+      align(s.size() + 1, sizeof(std::uint32_t));
+      _buf.insert(_buf.begin(), 0);
+      prepend(s.data(), s.size());
+      return push(static_cast<std::uint32_t>(s.size()));
+    }
+
+    // vector of scalars or structs, stored inline
+    template <typename S>
+    std::uint32_t create_vector(const S* first, std::size_t count,
+        std::size_t alignment = alignof(S)) {
+      align(count * sizeof(S), std::max(alignment, sizeof(std::uint32_t)));
+      prepend(first, count * sizeof(S));
+      return push(static_cast<std::uint32_t>(count));
+    }
+
+    std::uint32_t create_offset_vector(const std::vector<std::uint32_t>& offsets) {
+      align(offsets.size() * sizeof(std::uint32_t), sizeof(std::uint32_t));
+      for (auto it = offsets.rbegin(); it != offsets.rend(); ++it) {
+        push_offset(*it);
+      }
+      return push(static_cast<std::uint32_t>(offsets.size()));
+    }
+
+    void start_table() {
+      _fields.clear();
+      _table_start = size();
+    }
+
+    template <typename S>
+    void add_scalar(std::uint16_t id, S value) {
+      _fields.emplace_back(id, push(value));
+    }
+
+    void add_offset(std::uint16_t id, std::uint32_t target) {
+      _fields.emplace_back(id, push_offset(target));
+    }
+
+    template <typename S>
+    void add_struct(std::uint16_t id, const S& value, std::size_t alignment) {
+      align(sizeof(S), alignment);
+      prepend(&value, sizeof(S));
+      _fields.emplace_back(id, size());
+    }
+
+    std::uint32_t end_table() {
+      std::uint32_t table = push(std::int32_t(0));
+      std::uint16_t count = 0;
+      for (auto& field : _fields) {
+        count = std::max<std::uint16_t>(count, field.first + 1);
+      }
+      std::vector<std::uint16_t> entries(count, 0);
+      for (auto& field : _fields) {
+        entries[field.first] = static_cast<std::uint16_t>(table - field.second);
+      }
+      for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        push(*it);
+      }
+      push(static_cast<std::uint16_t>(table - _table_start));
+      std::uint32_t vtable = push(static_cast<std::uint16_t>(4 + 2 * count));
+      std::int32_t soffset = static_cast<std::int32_t>(vtable - table);
+      std::memcpy(&_buf[_buf.size() - table], &soffset, sizeof(soffset));
+      _fields.clear();
+      return table;
+    }
+
+    std::vector<unsigned char> finish(std::uint32_t root) {
+      align(sizeof(std::uint32_t), _minalign);
+      push_offset(root);
+      return std::move(_buf);
+    }
+};
+
+// Read-only view over a flatbuffer table, bounds checked against the
+// enclosing buffer.
+class arrow_flatbuffer_table {
+  private:
+    const unsigned char* _base;
+    std::size_t _size;
+    std::size_t _pos;
+    std::size_t _vtable;
+    std::uint16_t _vtable_size;
+
+  public:
+    template <typename S>
+    static S read(const unsigned char* base, std::size_t size, std::size_t pos) {
+      if (pos > size || size - pos < sizeof(S)) {
+        throw std::runtime_error("arrow: malformed flatbuffer");
+      }
+      S value;
+      std::memcpy(&value, base + pos, sizeof(S));
+      return value;
+    }
+
+    arrow_flatbuffer_table(const unsigned char* base, std::size_t size, std::size_t pos)
+      : _base(base), _size(size), _pos(pos)
+    {
+      _vtable = _pos - read<std::int32_t>(_base, _size, _pos);
+      _vtable_size = read<std::uint16_t>(_base, _size, _vtable);
+    }
+
+    static arrow_flatbuffer_table root(const unsigned char* base, std::size_t size,
+        std::size_t pos) {
+      return arrow_flatbuffer_table(base, size, pos + read<std::uint32_t>(base, size, pos));
+    }
+
+    // absolute position of a field, 0 if absent
+    std::size_t field(std::uint16_t id) const {
+      std::size_t entry = 4 + 2 * static_cast<std::size_t>(id);
+      if (entry + 2 > _vtable_size) {
+        return 0;
+      }
+      std::uint16_t offset = read<std::uint16_t>(_base, _size, _vtable + entry);
+      return offset ? _pos + offset : 0;
+    }
+
+    template <typename S>
+    S scalar(std::uint16_t id, S def = S()) const {
+      std::size_t pos = field(id);
+      return pos ? read<S>(_base, _size, pos) : def;
+    }
+
+    std::size_t indirect(std::uint16_t id) const {
+      std::size_t pos = field(id);
+      if (!pos) {
+        throw std::runtime_error("arrow: missing flatbuffer field");
+      }
+      return pos + read<std::uint32_t>(_base, _size, pos);
+    }
+
+    arrow_flatbuffer_table table(std::uint16_t id) const {
+      return arrow_flatbuffer_table(_base, _size, indirect(id));
+    }
+
+    // position of the first element, length through count
+    std::size_t vector(std::uint16_t id, std::uint32_t& count) const {
+      if (!field(id)) {
+        count = 0;
+        return 0;
+      }
+      std::size_t pos = indirect(id);
+      count = read<std::uint32_t>(_base, _size, pos);
+      return pos + sizeof(std::uint32_t);
+    }
+
+    arrow_flatbuffer_table vector_table(std::size_t first, std::uint32_t index) const {
+      std::size_t pos = first + 4 * static_cast<std::size_t>(index);
+      return arrow_flatbuffer_table(_base, _size, pos + read<std::uint32_t>(_base, _size, pos));
+    }
+
+    std::string string(std::uint16_t id) const {
+      std::uint32_t count = 0;
+      std::size_t first = vector(id, count);
+      if (first > _size || _size - first < count) {
+        throw std::runtime_error("arrow: malformed flatbuffer");
+      }
+      return std::string(reinterpret_cast<const char*>(_base + first), count);
+    }
+};
+
+template <typename U, typename = void>
+struct arrow_type;
+
+template <typename U>
+struct arrow_type<U, std::enable_if_t<std::is_integral<U>::value && !std::is_same<U, bool>::value>> {
+  static constexpr std::uint8_t type_type = static_cast<std::uint8_t>(arrow_type_id::int_);
+
+  static std::uint32_t create(arrow_flatbuffer_builder& fbb) {
+    fbb.start_table();
+    fbb.add_scalar<std::int32_t>(0, 8 * sizeof(U));
+    fbb.add_scalar<std::uint8_t>(1, std::is_signed<U>::value);
+    return fbb.end_table();
+  }
+
+  static bool matches(const arrow_field& f) {
+    return f.type == arrow_type_id::int_ && f.bit_width == 8 * sizeof(U)
+      && f.is_signed == std::is_signed<U>::value;
+  }
+};
+
+template <typename U>
+struct arrow_type<U, std::enable_if_t<std::is_same<U, float>::value || std::is_same<U, double>::value>> {
+  static constexpr std::uint8_t type_type = static_cast<std::uint8_t>(arrow_type_id::floating_point);
+  static constexpr std::int16_t precision = std::is_same<U, float>::value ? 1 : 2;
+
+  static std::uint32_t create(arrow_flatbuffer_builder& fbb) {
+    fbb.start_table();
+    fbb.add_scalar<std::int16_t>(0, precision);
+    return fbb.end_table();
+  }
+
+  static bool matches(const arrow_field& f) {
+    return f.type == arrow_type_id::floating_point && f.precision == precision;
+  }
+};
+
+template <>
+struct arrow_type<std::string> {
+  static constexpr std::uint8_t type_type = static_cast<std::uint8_t>(arrow_type_id::utf8);
+
+  static std::uint32_t create(arrow_flatbuffer_builder& fbb) {
+    fbb.start_table();
+    return fbb.end_table();
+  }
+
+  static bool matches(const arrow_field& f) {
+    return f.type == arrow_type_id::utf8;
+  }
+};
+
+struct arrow_buffer {
+  std::int64_t offset;
+  std::int64_t length;
+};
+
+struct arrow_field_node {
+  std::int64_t length;
+  std::int64_t null_count;
+};
+
+struct arrow_block {
+  std::int64_t offset;
+  std::int32_t meta_data_length;
+  std::int32_t padding;
+  std::int64_t body_length;
+};
+
+// Body buffers of one record batch. Trivially copyable columns point straight
+// into the column storage; string columns are staged into offsets/chars.
+struct arrow_batch_staging {
+  std::vector<std::pair<const char*, std::int64_t>> buffers;
+  std::vector<arrow_field_node> nodes;
+  std::vector<std::vector<std::int32_t>> offsets;
+  std::vector<std::string> chars;
+};
+
+template <typename U>
+void arrow_stage_column(const U* data, std::size_t n, arrow_batch_staging& staging) {
+  static_assert(std::is_trivially_copyable<U>::value, "arrow: unsupported column type");
+  staging.nodes.push_back({ static_cast<std::int64_t>(n), 0 });
+  staging.buffers.emplace_back(nullptr, 0);
+  staging.buffers.emplace_back(reinterpret_cast<const char*>(data), n * sizeof(U));
+}
+
+inline void arrow_stage_column(const std::string* data, std::size_t n,
+    arrow_batch_staging& staging) {
+  std::vector<std::int32_t> offsets(n + 1, 0);
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    total += data[i].size();
+  }
+  if (total > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+    throw std::length_error("arrow: string column exceeds 2GB");
+  }
+  std::string chars;
+  chars.reserve(total);
+  for (std::size_t i = 0; i < n; i++) {
+    chars += data[i];
+    offsets[i + 1] = static_cast<std::int32_t>(chars.size());
+  }
+  staging.offsets.push_back(std::move(offsets));
+  staging.chars.push_back(std::move(chars));
+  staging.nodes.push_back({ static_cast<std::int64_t>(n), 0 });
+  staging.buffers.emplace_back(nullptr, 0);
+  staging.buffers.emplace_back(reinterpret_cast<const char*>(staging.offsets.back().data()),
+      (n + 1) * sizeof(std::int32_t));
+  staging.buffers.emplace_back(staging.chars.back().data(), staging.chars.back().size());
+}
+
+template <typename T>
+class arrow_writer {
+  private:
+    static constexpr std::size_t N = std::tuple_size<T>::value;
+    static constexpr std::int16_t metadata_version = 4; // V5
+
+    std::ostream& _os;
+    std::int64_t _pos = 0;
+
+    void write(const void* bytes, std::size_t n) {
+      _os.write(static_cast<const char*>(bytes), n);
+      _pos += n;
+    }
+
+    void pad(std::size_t alignment) {
+      static const char zeros[64] = {};
+      write(zeros, (alignment - _pos % alignment) % alignment);
+    }
+
+    template <std::size_t ... Indices>
+    std::uint32_t create_schema(arrow_flatbuffer_builder& fbb,
+        const std::vector<std::string>& names, std::index_sequence<Indices ...>) {
+      std::uint32_t types[] = { 0, arrow_type<std::remove_cv_t<
+        typename std::tuple_element<Indices, T>::type>>::create(fbb) ... };
+      std::uint8_t type_types[] = { 0, arrow_type<std::remove_cv_t<
+        typename std::tuple_element<Indices, T>::type>>::type_type ... };
+      std::vector<std::uint32_t> fields;
+      for (std::size_t i = 0; i < N; i++) {
+        std::string name = i < names.size() ? names[i] : "f" + std::to_string(i);
+        std::uint32_t name_offset = fbb.create_string(name);
+        std::uint32_t children = fbb.create_offset_vector({});
+        fbb.start_table();
+        fbb.add_offset(0, name_offset);
+        fbb.add_scalar<std::uint8_t>(1, 0);
+        fbb.add_scalar<std::uint8_t>(2, type_types[i + 1]);
+        fbb.add_offset(3, types[i + 1]);
+        fbb.add_offset(5, children);
+        fields.push_back(fbb.end_table());
+      }
+      std::uint32_t field_vector = fbb.create_offset_vector(fields);
+      fbb.start_table();
+      fbb.add_scalar<std::int16_t>(0, 0);
+      fbb.add_offset(1, field_vector);
+      return fbb.end_table();
+    }
+
+    std::vector<unsigned char> message(arrow_flatbuffer_builder& fbb,
+        std::uint8_t header_type, std::uint32_t header, std::int64_t body_length) {
+      fbb.start_table();
+      fbb.add_scalar<std::int64_t>(3, body_length);
+      fbb.add_offset(2, header);
+      fbb.add_scalar<std::int16_t>(0, metadata_version);
+      fbb.add_scalar<std::uint8_t>(1, header_type);
+      return fbb.finish(fbb.end_table());
+    }
+
+    // encapsulated message, returns the metadata length including the prefix
+    std::int32_t write_message(const std::vector<unsigned char>& metadata) {
+      std::uint32_t continuation = 0xFFFFFFFF;
+      std::int32_t length = static_cast<std::int32_t>((metadata.size() + 7) / 8 * 8);
+      write(&continuation, sizeof(continuation));
+      write(&length, sizeof(length));
+      write(metadata.data(), metadata.size());
+      pad(8);
+      return length + 8;
+    }
+
+    template <std::size_t ... Indices>
+    void stage(const std::vector<unpack<T>>& v, arrow_batch_staging& staging,
+        std::index_sequence<Indices ...>) {
+      staging.offsets.reserve(N);
+      staging.chars.reserve(N);
+      using dummy = int[];
+      (void)dummy{1, (arrow_stage_column(v.template data<Indices>(), v.size(), staging),
+          void(), int{}) ... };
+    }
+
+  public:
+    arrow_writer(std::ostream& os) : _os(os) {}
+
+    void write_magic() {
+      write("ARROW1\0\0", 8);
+    }
+
+    void write_schema(const std::vector<std::string>& names) {
+      arrow_flatbuffer_builder fbb;
+      std::uint32_t schema = create_schema(fbb, names, std::make_index_sequence<N>{});
+      write_message(message(fbb, 1, schema, 0));
+    }
+
+    arrow_block write_batch(const std::vector<unpack<T>>& v) {
+      arrow_batch_staging staging;
+      stage(v, staging, std::make_index_sequence<N>{});
+      std::vector<arrow_buffer> buffers;
+      std::int64_t body_length = 0;
+      for (auto& buffer : staging.buffers) {
+        buffers.push_back({ body_length, buffer.second });
+        body_length += (buffer.second + 7) / 8 * 8;
+      }
+      arrow_flatbuffer_builder fbb;
+      std::uint32_t buffer_vector = fbb.create_vector(buffers.data(), buffers.size(), 8);
+      std::uint32_t node_vector = fbb.create_vector(staging.nodes.data(), staging.nodes.size(), 8);
+      fbb.start_table();
+      fbb.add_scalar<std::int64_t>(0, v.size());
+      fbb.add_offset(1, node_vector);
+      fbb.add_offset(2, buffer_vector);
+      std::uint32_t batch = fbb.end_table();
+
+      arrow_block block = { _pos, 0, 0, body_length };
+      block.meta_data_length = write_message(message(fbb, 3, batch, body_length));
+      for (auto& buffer : staging.buffers) {
+        write(buffer.first, buffer.second);
+        pad(8);
+      }
+      return block;
+    }
+
+    void write_end_of_stream() {
+      std::uint32_t eos[] = { 0xFFFFFFFF, 0 };
+      write(eos, sizeof(eos));
+    }
+
+    void write_footer(const std::vector<std::string>& names,
+        const std::vector<arrow_block>& blocks) {
+      arrow_flatbuffer_builder fbb;
+      std::uint32_t schema = create_schema(fbb, names, std::make_index_sequence<N>{});
+      std::uint32_t batches = fbb.create_vector(blocks.data(), blocks.size(), 8);
+      std::uint32_t dictionaries = fbb.create_vector<arrow_block>(nullptr, 0, 8);
+      fbb.start_table();
+      fbb.add_offset(1, schema);
+      fbb.add_offset(2, dictionaries);
+      fbb.add_offset(3, batches);
+      fbb.add_scalar<std::int16_t>(0, metadata_version);
+      std::vector<unsigned char> footer = fbb.finish(fbb.end_table());
+      write(footer.data(), footer.size());
+      std::int32_t length = static_cast<std::int32_t>(footer.size());
+      write(&length, sizeof(length));
+      write("ARROW1", 6);
+    }
+};
+
+// Writes v as an Arrow IPC stream (schema, one record batch, end-of-stream).
+template <typename T>
+void write_arrow_stream(const std::vector<unpack<T>>& v, std::ostream& os,
+    const std::vector<std::string>& names = {}) {
+  arrow_writer<T> writer(os);
+  writer.write_schema(names);
+  writer.write_batch(v);
+  writer.write_end_of_stream();
+}
+
+// Writes v as an Arrow IPC file. Column buffers of trivially copyable
+// columns are written directly from the column storage.
+template <typename T>
+void write_arrow_file(const std::vector<unpack<T>>& v, const std::string& path,
+    const std::vector<std::string>& names = {}) {
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  if (!os) {
+    throw std::runtime_error("arrow: cannot open " + path);
+  }
+  arrow_writer<T> writer(os);
+  writer.write_magic();
+  writer.write_schema(names);
+  std::vector<arrow_block> blocks = { writer.write_batch(v) };
+  writer.write_end_of_stream();
+  writer.write_footer(names, blocks);
+  if (!os) {
+    throw std::runtime_error("arrow: cannot write " + path);
+  }
+}
+
+// Zero-copy view of one column of one record batch.
+template <typename U>
+class arrow_column {
+  private:
+    const U* _data;
+    std::size_t _size;
+
+  public:
+    arrow_column(const U* data, std::size_t size) : _data(data), _size(size) {}
+
+    const U* data() const { return _data; }
+    const U* begin() const { return _data; }
+    const U* end() const { return _data + _size; }
+    std::size_t size() const { return _size; }
+    const U& operator[](std::size_t index) const { return _data[index]; }
+};
+
+template <>
+class arrow_column<std::string> {
+  private:
+    const std::int32_t* _offsets;
+    const char* _chars;
+    std::size_t _size;
+
+  public:
+    arrow_column(const std::int32_t* offsets, const char* chars, std::size_t size)
+      : _offsets(offsets), _chars(chars), _size(size) {}
+
+    std::size_t size() const { return _size; }
+    const char* data(std::size_t index) const { return _chars + _offsets[index]; }
+    std::size_t length(std::size_t index) const {
+      return _offsets[index + 1] - _offsets[index];
+    }
+    std::string operator[](std::size_t index) const {
+      return std::string(data(index), length(index));
+    }
+};
+
+// Reads an Arrow IPC file or stream. Files are memory mapped and columns are
+// handed out as views into the mapping; read() copies them into a
+// std::vector<unpack<T>>, one bulk copy per column and batch.
+class arrow_reader {
+  private:
+    struct batch {
+      std::int64_t length;
+      std::size_t body;
+      std::int64_t body_length;
+      std::vector<arrow_field_node> nodes;
+      std::vector<arrow_buffer> buffers;
+      std::vector<std::size_t> first_buffer;
+    };
+
+    const unsigned char* _data = nullptr;
+    std::size_t _size = 0;
+    void* _mapping = nullptr;
+    std::vector<arrow_field> _fields;
+    std::vector<batch> _batches;
+
+    static std::size_t buffer_count(const arrow_field& f) {
+      return f.type == arrow_type_id::utf8 ? 3 : 2;
+    }
+
+    void parse_schema(const arrow_flatbuffer_table& schema) {
+      std::uint32_t count = 0;
+      std::size_t first = schema.vector(1, count);
+      _fields.clear();
+      for (std::uint32_t i = 0; i < count; i++) {
+        arrow_flatbuffer_table f = schema.vector_table(first, i);
+        arrow_field field;
+        field.name = f.string(0);
+        field.type = static_cast<arrow_type_id>(f.scalar<std::uint8_t>(2));
+        switch (field.type) {
+          case arrow_type_id::int_: {
+            arrow_flatbuffer_table type = f.table(3);
+            field.bit_width = type.scalar<std::int32_t>(0);
+            field.is_signed = type.scalar<std::uint8_t>(1);
+            break;
+          }
+          case arrow_type_id::floating_point:
+            field.precision = f.table(3).scalar<std::int16_t>(0);
+            break;
+          case arrow_type_id::utf8:
+            break;
+          default:
+            throw std::runtime_error("arrow: unsupported type for field " + field.name);
+        }
+        _fields.push_back(field);
+      }
+    }
+
+    void parse_batch(const arrow_flatbuffer_table& rb, std::size_t body,
+        std::int64_t body_length) {
+      if (rb.field(3)) {
+        throw std::runtime_error("arrow: compressed record batches are not supported");
+      }
+      batch b;
+      b.length = rb.scalar<std::int64_t>(0);
+      b.body = body;
+      b.body_length = body_length;
+      std::uint32_t count = 0;
+      std::size_t first = rb.vector(1, count);
+      for (std::uint32_t i = 0; i < count; i++) {
+        b.nodes.push_back({
+          arrow_flatbuffer_table::read<std::int64_t>(_data, _size, first + 16 * i),
+          arrow_flatbuffer_table::read<std::int64_t>(_data, _size, first + 16 * i + 8) });
+      }
+      first = rb.vector(2, count);
+      for (std::uint32_t i = 0; i < count; i++) {
+        arrow_buffer buffer = {
+          arrow_flatbuffer_table::read<std::int64_t>(_data, _size, first + 16 * i),
+          arrow_flatbuffer_table::read<std::int64_t>(_data, _size, first + 16 * i + 8) };
+        if (buffer.offset < 0 || buffer.length < 0
+            || buffer.offset + buffer.length > body_length) {
+          throw std::runtime_error("arrow: buffer out of bounds");
+        }
+        b.buffers.push_back(buffer);
+      }
+      std::size_t next = 0;
+      for (auto& f : _fields) {
+        b.first_buffer.push_back(next);
+        next += buffer_count(f);
+      }
+      if (b.nodes.size() != _fields.size() || b.buffers.size() != next) {
+        throw std::runtime_error("arrow: record batch does not match schema");
+      }
+      _batches.push_back(std::move(b));
+    }
+
+    void parse() {
+      std::size_t pos = 0;
+      if (_size >= 8 && std::memcmp(_data, "ARROW1", 6) == 0) {
+        pos = 8;
+      }
+      while (pos + 4 <= _size) {
+        std::uint32_t length = arrow_flatbuffer_table::read<std::uint32_t>(_data, _size, pos);
+        pos += 4;
+        if (length == 0xFFFFFFFF) {
+          length = arrow_flatbuffer_table::read<std::uint32_t>(_data, _size, pos);
+          pos += 4;
+        }
+        if (length == 0) {
+          break;
+        }
+        auto msg = arrow_flatbuffer_table::root(_data, _size, pos);
+        std::uint8_t header_type = msg.scalar<std::uint8_t>(1);
+        std::int64_t body_length = msg.scalar<std::int64_t>(3);
+        std::size_t body = pos + length;
+        if (body_length < 0 || body > _size || _size - body < static_cast<std::size_t>(body_length)) {
+          throw std::runtime_error("arrow: message body out of bounds");
+        }
+        if (header_type == 1) {
+          parse_schema(msg.table(2));
+        } else if (header_type == 3) {
+          parse_batch(msg.table(2), body, body_length);
+        } else {
+          throw std::runtime_error("arrow: unsupported message type");
+        }
+        pos = body + body_length;
+      }
+    }
+
+    const unsigned char* buffer(std::size_t b, std::size_t field, std::size_t i) const {
+      const batch& bt = _batches.at(b);
+      return _data + bt.body + bt.buffers[bt.first_buffer.at(field) + i].offset;
+    }
+
+    template <typename U>
+    static const U* aligned(const unsigned char* p) {
+      if (reinterpret_cast<std::uintptr_t>(p) % alignof(U) != 0) {
+        throw std::runtime_error("arrow: misaligned buffer");
+      }
+      return reinterpret_cast<const U*>(p);
+    }
+
+    template <typename U>
+    void check(std::size_t b, std::size_t field) const {
+      if (!arrow_type<U>::matches(_fields.at(field))) {
+        throw std::invalid_argument("arrow: type mismatch for field " + _fields[field].name);
+      }
+      const batch& bt = _batches.at(b);
+      std::size_t first = bt.first_buffer[field];
+      std::size_t needed = std::is_same<U, std::string>::value
+        ? (bt.length + 1) * sizeof(std::int32_t) : bt.length * sizeof(U);
+      if (bt.buffers[first + 1].length < static_cast<std::int64_t>(needed)) {
+        throw std::runtime_error("arrow: buffer too small for field " + _fields[field].name);
+      }
+    }
+
+    template <typename T, std::size_t ... Indices>
+    void read_batch(std::size_t b, std::vector<unpack<T>>& v, std::size_t first,
+        std::index_sequence<Indices ...>) const {
+      using dummy = int[];
+      (void)dummy{1, (read_column(column<std::remove_cv_t<
+        typename std::tuple_element<Indices, T>::type>>(b, Indices),
+        v.template data<Indices>() + first), void(), int{}) ... };
+    }
+
+    template <typename U>
+    static void read_column(const arrow_column<U>& c, U* out) {
+      std::memcpy(out, c.data(), c.size() * sizeof(U));
+    }
+
+    static void read_column(const arrow_column<std::string>& c, std::string* out) {
+      for (std::size_t i = 0; i < c.size(); i++) {
+        out[i].assign(c.data(i), c.length(i));
+      }
+    }
+
+  public:
+    explicit arrow_reader(const std::string& path) {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        throw std::runtime_error("arrow: cannot open " + path);
+      }
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("arrow: cannot stat " + path);
+      }
+      _size = st.st_size;
+      if (_size > 0) {
+        _mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      }
+      ::close(fd);
+      if (_mapping == MAP_FAILED) {
+        _mapping = nullptr;
+        throw std::runtime_error("arrow: cannot map " + path);
+      }
+      _data = static_cast<const unsigned char*>(_mapping);
+      try {
+        parse();
+      } catch (...) {
+        if (_mapping) {
+          ::munmap(_mapping, _size);
+        }
+        throw;
+      }
+    }
+
+    // borrows data, which must outlive the reader
+    arrow_reader(const void* data, std::size_t size)
+      : _data(static_cast<const unsigned char*>(data)), _size(size)
+    {
+      parse();
+    }
+
+    arrow_reader(const arrow_reader&) = delete;
+    arrow_reader& operator=(const arrow_reader&) = delete;
+
+    arrow_reader(arrow_reader&& r)
+      : _data(r._data), _size(r._size), _mapping(r._mapping),
+        _fields(std::move(r._fields)), _batches(std::move(r._batches))
+    {
+      r._mapping = nullptr;
+    }
+
+    ~arrow_reader() {
+      if (_mapping) {
+        ::munmap(_mapping, _size);
+      }
+    }
+
+    const std::vector<arrow_field>& fields() const {
+      return _fields;
+    }
+
+    std::size_t num_batches() const {
+      return _batches.size();
+    }
+
+    std::size_t num_rows(std::size_t b) const {
+      return _batches.at(b).length;
+    }
+
+    std::size_t num_rows() const {
+      std::size_t rows = 0;
+      for (auto& b : _batches) {
+        rows += b.length;
+      }
+      return rows;
+    }
+
+    template <typename U>
+    arrow_column<U> column(std::size_t b, std::size_t field) const {
+      check<U>(b, field);
+      return arrow_column<U>(aligned<U>(buffer(b, field, 1)), num_rows(b));
+    }
+
+    // Appends all record batches to v.
+    template <typename T>
+    void read(std::vector<unpack<T>>& v) const {
+      constexpr std::size_t N = std::tuple_size<T>::value;
+      if (_fields.size() != N) {
+        throw std::invalid_argument("arrow: schema has " + std::to_string(_fields.size())
+            + " fields, expected " + std::to_string(N));
+      }
+      for (auto& b : _batches) {
+        for (auto& node : b.nodes) {
+          if (node.null_count != 0) {
+            throw std::runtime_error("arrow: null values are not supported");
+          }
+        }
+      }
+      std::size_t first = v.size();
+      v.resize(first + num_rows());
+      for (std::size_t b = 0; b < _batches.size(); b++) {
+        read_batch(b, v, first, std::make_index_sequence<N>{});
+        first += num_rows(b);
+      }
+    }
+};
+
+template <>
+inline arrow_column<std::string> arrow_reader::column<std::string>(std::size_t b,
+    std::size_t field) const {
+  check<std::string>(b, field);
+  const std::int32_t* offsets = aligned<std::int32_t>(buffer(b, field, 1));
+  const batch& bt = _batches[b];
+  std::int64_t chars = bt.buffers[bt.first_buffer[field] + 2].length;
+  for (std::size_t i = 0; i < num_rows(b); i++) {
+    if (offsets[i] < 0 || offsets[i] > offsets[i + 1] || offsets[i + 1] > chars) {
+      throw std::runtime_error("arrow: invalid offsets for field " + _fields[field].name);
+    }
+  }
+  return arrow_column<std::string>(offsets,
+      reinterpret_cast<const char*>(buffer(b, field, 2)), num_rows(b));
+}
+
+template <typename T>
+std::vector<unpack<T>> read_arrow_file(const std::string& path) {
+  std::vector<unpack<T>> v;
+  arrow_reader(path).read(v);
+  return v;
+}
+
+#endif
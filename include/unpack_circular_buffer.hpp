@@ -0,0 +1,392 @@
+#ifndef UNPACK_CIRCULAR_BUFFER
+#define UNPACK_CIRCULAR_BUFFER
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "unpack_details.hpp"
+#include "unpack_iterator.hpp"
+#include "unpack_simd.hpp"
+
+// Iterator over one column of a circular_buffer: the column storage, its
+// capacity, the slot of the first row and the position counted from the
+// first row.
+template <typename X>
+class unpack_ring_iterator {
+  private:
+    X* _base;
+    std::size_t _capacity;
+    std::size_t _head;
+    std::ptrdiff_t _index;
+
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = typename std::remove_const<X>::type;
+    using pointer = X*;
+    using reference = X&;
+    using iterator_category = std::random_access_iterator_tag;
+
+    unpack_ring_iterator() : _base(nullptr), _capacity(1), _head(0), _index(0) {}
+
+    unpack_ring_iterator(X* base, std::size_t capacity, std::size_t head, std::ptrdiff_t index)
+      : _base(base), _capacity(capacity), _head(head), _index(index)
+    {
+    }
+
+    reference operator*() const {
+      std::size_t slot = _head + _index;
+      return _base[slot >= _capacity ? slot - _capacity : slot];
+    }
+
+    pointer operator->() const {
+      return &operator*();
+    }
+
+    reference operator[](difference_type dt) const {
+      return *(*this + dt);
+    }
+
+    unpack_ring_iterator& operator++() {
+      _index++;
+      return *this;
+    }
+
+    unpack_ring_iterator operator++(int) {
+      auto it = *this;
+      _index++;
+      return it;
+    }
+
+    unpack_ring_iterator& operator--() {
+      _index--;
+      return *this;
+    }
+
+    unpack_ring_iterator operator--(int) {
+      auto it = *this;
+      _index--;
+      return it;
+    }
+
+    unpack_ring_iterator& operator+=(difference_type dt) {
+      _index += dt;
+      return *this;
+    }
+
+    unpack_ring_iterator& operator-=(difference_type dt) {
+      _index -= dt;
+      return *this;
+    }
+
+    unpack_ring_iterator operator+(difference_type dt) const {
+      return unpack_ring_iterator(_base, _capacity, _head, _index + dt);
+    }
+
+    unpack_ring_iterator operator-(difference_type dt) const {
+      return unpack_ring_iterator(_base, _capacity, _head, _index - dt);
+    }
+
+    difference_type operator-(const unpack_ring_iterator& rhs) const {
+      return _index - rhs._index;
+    }
+
+    bool operator==(const unpack_ring_iterator& rhs) const {
+      return _index == rhs._index;
+    }
+
+    bool operator!=(const unpack_ring_iterator& rhs) const {
+      return _index != rhs._index;
+    }
+
+    bool operator<(const unpack_ring_iterator& rhs) const {
+      return _index < rhs._index;
+    }
+
+    bool operator<=(const unpack_ring_iterator& rhs) const {
+      return _index <= rhs._index;
+    }
+
+    bool operator>(const unpack_ring_iterator& rhs) const {
+      return _index > rhs._index;
+    }
+
+    bool operator>=(const unpack_ring_iterator& rhs) const {
+      return _index >= rhs._index;
+    }
+
+    friend unpack_ring_iterator operator+(difference_type dt, const unpack_ring_iterator& it) {
+      return it + dt;
+    }
+};
+
+template <typename T, typename Indices>
+struct circular_buffer_types_helper;
+
+template <typename T, std::size_t ... Indices>
+struct circular_buffer_types_helper<T, std::index_sequence<Indices ...>> {
+  using iters_type = std::tuple<
+    unpack_ring_iterator<typename std::tuple_element<Indices, T>::type> ...>;
+  using const_iters_type = std::tuple<
+    unpack_ring_iterator<const typename std::tuple_element<Indices, T>::type> ...>;
+};
+
+template <typename T>
+struct circular_buffer_types {
+  using Indices = std::make_index_sequence<std::tuple_size<T>::value>;
+  using iters_type = typename circular_buffer_types_helper<T, Indices>::iters_type;
+  using const_iters_type = typename circular_buffer_types_helper<T, Indices>::const_iters_type;
+};
+
+template <typename T>
+class circular_buffer;
+
+// A fixed capacity ring of rows, one column vector per column, for sliding
+// windows. Pushing at either end of a full buffer overwrites the row at
+// the other end, and popping only moves the window, so every push and pop
+// is O(1) and no column is ever shifted. The live rows of a column are at
+// most two contiguous spans, see for_each_chunk, over which the rolling
+// aggregates run the SIMD column kernels.
+template <typename T>
+class circular_buffer<unpack<T>> {
+  private:
+    using data_type = typename unpack_inversion<T>::type;
+    using types = circular_buffer_types<T>;
+    using tuple_refs_type = typename unpack_tuple_refs_type<T>::type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+    data_type _data;
+    std::size_t _capacity;
+    std::size_t _head;
+    std::size_t _size;
+
+    std::size_t slot(std::size_t index) const {
+      std::size_t slot = _head + index;
+      return slot >= _capacity ? slot - _capacity : slot;
+    }
+
+    template <typename X, typename R, typename Op>
+    static R reduce_span(const X* p, std::size_t n, R init, Op& op, simd_level level) {
+      UNPACK_COLUMN_DISPATCH(level, reduce, p, n, init, op)
+    }
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = unpack_iterator<typename types::iters_type>;
+    using const_iterator = unpack_const_iterator<typename types::const_iters_type>;
+
+    // Throws std::invalid_argument if capacity is 0.
+    explicit circular_buffer(std::size_t capacity) : _capacity(capacity), _head(0), _size(0) {
+      if (capacity == 0) {
+        throw std::invalid_argument("circular_buffer: capacity must not be 0");
+      }
+      tuple_for_each([capacity](auto& cur_vec) { cur_vec.resize(capacity); }, _data);
+    }
+
+    std::size_t size() const {
+      return _size;
+    }
+
+    std::size_t capacity() const {
+      return _capacity;
+    }
+
+    bool empty() const {
+      return _size == 0;
+    }
+
+    bool full() const {
+      return _size == _capacity;
+    }
+
+    void clear() {
+      _head = 0;
+      _size = 0;
+    }
+
+    // Appends row, overwriting the first row if the buffer is full.
+    void push_back(const T& row) {
+      std::size_t s = slot(_size);
+      tuple_for_each([s](auto& cur_vec, auto& cur_elem) { cur_vec[s] = cur_elem; }, _data, row);
+      if (full()) {
+        _head = slot(1);
+      } else {
+        _size++;
+      }
+    }
+
+    // Prepends row, overwriting the last row if the buffer is full.
+    void push_front(const T& row) {
+      _head = _head ? _head - 1 : _capacity - 1;
+      tuple_for_each([this](auto& cur_vec, auto& cur_elem) {
+        cur_vec[_head] = cur_elem;
+      }, _data, row);
+      if (!full()) {
+        _size++;
+      }
+    }
+
+    void pop_back() {
+      _size--;
+    }
+
+    void pop_front() {
+      _head = slot(1);
+      _size--;
+    }
+
+    tuple_refs_type operator[](std::size_t index) {
+      return tuple_r_at_index(_data, slot(index));
+    }
+
+    tuple_const_refs_type operator[](std::size_t index) const {
+      return tuple_r_at_index(_data, slot(index));
+    }
+
+    tuple_refs_type at(std::size_t index) {
+      throw_if_out_of_bounds(index, _size);
+      return operator[](index);
+    }
+
+    tuple_const_refs_type at(std::size_t index) const {
+      throw_if_out_of_bounds(index, _size);
+      return operator[](index);
+    }
+
+    tuple_refs_type front() {
+      return operator[](0);
+    }
+
+    tuple_const_refs_type front() const {
+      return operator[](0);
+    }
+
+    tuple_refs_type back() {
+      return operator[](_size - 1);
+    }
+
+    tuple_const_refs_type back() const {
+      return operator[](_size - 1);
+    }
+
+    iterator begin() {
+      return make_iterator(0);
+    }
+
+    iterator end() {
+      return make_iterator(_size);
+    }
+
+    const_iterator begin() const {
+      return make_const_iterator(0);
+    }
+
+    const_iterator end() const {
+      return make_const_iterator(_size);
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+    template <std::size_t N>
+    auto begin() {
+      return unpack_ring_iterator<typename std::tuple_element<N, T>::type>(
+          std::get<N>(_data).data(), _capacity, _head, 0);
+    }
+
+    template <std::size_t N>
+    auto end() {
+      return begin<N>() + _size;
+    }
+
+    template <std::size_t N>
+    auto begin() const {
+      return unpack_ring_iterator<const typename std::tuple_element<N, T>::type>(
+          std::get<N>(_data).data(), _capacity, _head, 0);
+    }
+
+    template <std::size_t N>
+    auto end() const {
+      return begin<N>() + _size;
+    }
+
+    // Calls f(data, rows) for the contiguous spans of column N holding the
+    // live rows, in row order: one span, or two if the rows wrap around.
+    template <std::size_t N, typename F>
+    void for_each_chunk(F&& f) const {
+      const auto* p = std::get<N>(_data).data();
+      std::size_t first = std::min(_size, _capacity - _head);
+      if (first) {
+        f(p + _head, first);
+      }
+      if (_size > first) {
+        f(p, _size - first);
+      }
+    }
+
+    // Folds the live rows of column N into init with op, in unspecified
+    // order, with the SIMD column kernels.
+    template <std::size_t N, typename R, typename Op>
+    R reduce(R init, Op op, simd_level level = simd_runtime_level()) const {
+      for_each_chunk<N>([&](const auto* p, std::size_t n) {
+        init = reduce_span(p, n, init, op, level);
+      });
+      return init;
+    }
+
+    template <std::size_t N>
+    typename std::tuple_element<N, T>::type sum() const {
+      using X = typename std::tuple_element<N, T>::type;
+      return reduce<N>(X(), [](X a, X b) { return a + b; });
+    }
+
+    template <std::size_t N>
+    double mean() const {
+      return static_cast<double>(sum<N>()) / _size;
+    }
+
+    // Smallest element of column N; the buffer must not be empty.
+    template <std::size_t N>
+    typename std::tuple_element<N, T>::type min() const {
+      using X = typename std::tuple_element<N, T>::type;
+      return reduce<N>(std::get<N>(front()), [](X a, X b) { return b < a ? b : a; });
+    }
+
+    // Largest element of column N; the buffer must not be empty.
+    template <std::size_t N>
+    typename std::tuple_element<N, T>::type max() const {
+      using X = typename std::tuple_element<N, T>::type;
+      return reduce<N>(std::get<N>(front()), [](X a, X b) { return a < b ? b : a; });
+    }
+
+  private:
+    iterator make_iterator(std::size_t index) {
+      std::size_t capacity = _capacity;
+      std::size_t head = _head;
+      return iterator(make_tuple_vec_iter(_data, [=](auto& cur_vec) {
+        using X = typename std::remove_reference<decltype(cur_vec[0])>::type;
+        return unpack_ring_iterator<X>(cur_vec.data(), capacity, head, index);
+      }));
+    }
+
+    const_iterator make_const_iterator(std::size_t index) const {
+      std::size_t capacity = _capacity;
+      std::size_t head = _head;
+      return const_iterator(make_tuple_vec_const_iter(_data, [=](auto& cur_vec) {
+        using X = typename std::remove_reference<decltype(cur_vec[0])>::type;
+        return unpack_ring_iterator<X>(cur_vec.data(), capacity, head, index);
+      }));
+    }
+};
+
+#endif
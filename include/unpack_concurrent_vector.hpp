@@ -0,0 +1,437 @@
+#ifndef UNPACK_CONCURRENT_VECTOR
+#define UNPACK_CONCURRENT_VECTOR
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "unpack_details.hpp"
+#include "unpack_iterator.hpp"
+
+// Rows of the first chunk of a concurrent_vector, as a power of two. Chunk
+// k holds unpack_concurrent_chunk_rows << k rows, so a fixed table of
+// unpack_concurrent_chunks chunks is enough for any size and is never
+// reallocated while producers append.
+constexpr std::size_t unpack_concurrent_chunk_shift = 10;
+constexpr std::size_t unpack_concurrent_chunk_rows = std::size_t(1) << unpack_concurrent_chunk_shift;
+constexpr std::size_t unpack_concurrent_chunks = 48;
+
+struct unpack_chunk_position {
+  std::size_t chunk;
+  std::size_t offset;
+};
+
+inline std::size_t unpack_chunk_rows(std::size_t chunk) {
+  return unpack_concurrent_chunk_rows << chunk;
+}
+
+// Chunk k starts at row unpack_concurrent_chunk_rows * (2^k - 1).
+inline unpack_chunk_position unpack_locate_row(std::size_t row) {
+  std::size_t j = (row >> unpack_concurrent_chunk_shift) + 1;
+#if defined(__GNUC__)
+  std::size_t chunk = 63 - __builtin_clzll(static_cast<unsigned long long>(j));
+#else
+  std::size_t chunk = 0;
+  while (j >>= 1) {
+    chunk++;
+  }
+#endif
+  return { chunk, row - unpack_concurrent_chunk_rows * ((std::size_t(1) << chunk) - 1) };
+}
+
+// One column of a concurrent_vector: a fixed table of chunks, allocated on
+// first use by whichever producer needs them first.
+template <typename X>
+class unpack_concurrent_column {
+  private:
+    mutable std::atomic<X*> _chunks[unpack_concurrent_chunks];
+
+  public:
+    unpack_concurrent_column() {
+      for (auto& chunk : _chunks) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    unpack_concurrent_column(const unpack_concurrent_column&) = delete;
+    unpack_concurrent_column& operator=(const unpack_concurrent_column&) = delete;
+
+    ~unpack_concurrent_column() {
+      for (std::size_t k = 0; k < unpack_concurrent_chunks; k++) {
+        X* chunk = _chunks[k].load(std::memory_order_relaxed);
+        if (chunk) {
+          std::allocator<X>().deallocate(chunk, unpack_chunk_rows(k));
+        }
+      }
+    }
+
+    // Chunk k, allocating it if no producer has yet. Racing producers each
+    // allocate and all but the one installing its chunk free theirs.
+    X* chunk(std::size_t k) {
+      X* chunk = _chunks[k].load(std::memory_order_acquire);
+      if (chunk) {
+        return chunk;
+      }
+      X* fresh = std::allocator<X>().allocate(unpack_chunk_rows(k));
+      if (_chunks[k].compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+        return fresh;
+      }
+      std::allocator<X>().deallocate(fresh, unpack_chunk_rows(k));
+      return chunk;
+    }
+
+    X* existing_chunk(std::size_t k) const {
+      return _chunks[k].load(std::memory_order_acquire);
+    }
+
+    X& operator[](std::size_t row) const {
+      unpack_chunk_position position = unpack_locate_row(row);
+      return existing_chunk(position.chunk)[position.offset];
+    }
+
+    void destroy(std::size_t first, std::size_t last) {
+      for (std::size_t row = first; row < last; row++) {
+        operator[](row).~X();
+      }
+    }
+};
+
+// Iterator over one column of a concurrent_vector.
+template <typename X>
+class unpack_concurrent_iterator {
+  private:
+    using column_type = unpack_concurrent_column<typename std::remove_const<X>::type>;
+    const column_type* _column;
+    std::ptrdiff_t _index;
+
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = typename std::remove_const<X>::type;
+    using pointer = X*;
+    using reference = X&;
+    using iterator_category = std::random_access_iterator_tag;
+
+    unpack_concurrent_iterator() : _column(nullptr), _index(0) {}
+
+    unpack_concurrent_iterator(const column_type* column, std::ptrdiff_t index)
+      : _column(column), _index(index)
+    {
+    }
+
+    reference operator*() const {
+      return (*_column)[_index];
+    }
+
+    pointer operator->() const {
+      return &operator*();
+    }
+
+    reference operator[](difference_type dt) const {
+      return (*_column)[_index + dt];
+    }
+
+    unpack_concurrent_iterator& operator++() {
+      _index++;
+      return *this;
+    }
+
+    unpack_concurrent_iterator operator++(int) {
+      auto it = *this;
+      _index++;
+      return it;
+    }
+
+    unpack_concurrent_iterator& operator--() {
+      _index--;
+      return *this;
+    }
+
+    unpack_concurrent_iterator operator--(int) {
+      auto it = *this;
+      _index--;
+      return it;
+    }
+
+    unpack_concurrent_iterator& operator+=(difference_type dt) {
+      _index += dt;
+      return *this;
+    }
+
+    unpack_concurrent_iterator& operator-=(difference_type dt) {
+      _index -= dt;
+      return *this;
+    }
+
+    unpack_concurrent_iterator operator+(difference_type dt) const {
+      return unpack_concurrent_iterator(_column, _index + dt);
+    }
+
+    unpack_concurrent_iterator operator-(difference_type dt) const {
+      return unpack_concurrent_iterator(_column, _index - dt);
+    }
+
+    difference_type operator-(const unpack_concurrent_iterator& rhs) const {
+      return _index - rhs._index;
+    }
+
+    bool operator==(const unpack_concurrent_iterator& rhs) const {
+      return _index == rhs._index;
+    }
+
+    bool operator!=(const unpack_concurrent_iterator& rhs) const {
+      return _index != rhs._index;
+    }
+
+    bool operator<(const unpack_concurrent_iterator& rhs) const {
+      return _index < rhs._index;
+    }
+
+    bool operator<=(const unpack_concurrent_iterator& rhs) const {
+      return _index <= rhs._index;
+    }
+
+    bool operator>(const unpack_concurrent_iterator& rhs) const {
+      return _index > rhs._index;
+    }
+
+    bool operator>=(const unpack_concurrent_iterator& rhs) const {
+      return _index >= rhs._index;
+    }
+
+    friend unpack_concurrent_iterator operator+(difference_type dt,
+        const unpack_concurrent_iterator& it) {
+      return it + dt;
+    }
+};
+
+template <typename T, typename Indices>
+struct concurrent_vector_types_helper;
+
+template <typename T, std::size_t ... Indices>
+struct concurrent_vector_types_helper<T, std::index_sequence<Indices ...>> {
+  using data_type = std::tuple<
+    unpack_concurrent_column<typename std::tuple_element<Indices, T>::type> ...>;
+  using iters_type = std::tuple<
+    unpack_concurrent_iterator<typename std::tuple_element<Indices, T>::type> ...>;
+  using const_iters_type = std::tuple<
+    unpack_concurrent_iterator<const typename std::tuple_element<Indices, T>::type> ...>;
+  static constexpr bool nothrow_copyable = std::is_same<
+    std::integer_sequence<bool, true, std::is_nothrow_copy_constructible<
+      typename std::tuple_element<Indices, T>::type>::value ...>,
+    std::integer_sequence<bool, std::is_nothrow_copy_constructible<
+      typename std::tuple_element<Indices, T>::type>::value ..., true>>::value;
+};
+
+template <typename T>
+struct concurrent_vector_types {
+  using Indices = std::make_index_sequence<std::tuple_size<T>::value>;
+  using helper = concurrent_vector_types_helper<T, Indices>;
+  using data_type = typename helper::data_type;
+  using iters_type = typename helper::iters_type;
+  using const_iters_type = typename helper::const_iters_type;
+};
+
+template <typename T>
+class concurrent_vector;
+
+// An append-only vector<unpack<T>> that any number of threads can append
+// to at once. A producer reserves a range of rows with one atomic add,
+// writes its columns into chunks that never move, and publishes the range.
+// size() is the published watermark: every row below it is fully written,
+// so readers may read rows below size() while producers keep appending.
+// Ranges are published in the order they were reserved; a producer only
+// waits for producers that reserved earlier rows to finish writing them,
+// never on a lock. Column types must be nothrow copy constructible, since
+// a reserved range has to be written before later ones can be published.
+template <typename T>
+class concurrent_vector<unpack<T>> {
+  private:
+    using types = concurrent_vector_types<T>;
+    using tuple_refs_type = typename unpack_tuple_refs_type<T>::type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+
+    static_assert(types::helper::nothrow_copyable,
+        "concurrent_vector: columns must be nothrow copy constructible");
+
+    typename types::data_type _data;
+    std::atomic<std::size_t> _reserved;
+    std::atomic<std::size_t> _size;
+
+    // Calls f(columns, rows) for each chunk overlapping rows [first, last),
+    // columns being the tuple of pointers to the first of those rows in
+    // every column and rows their number.
+    template <typename F>
+    void for_each_part(std::size_t first, std::size_t last, F&& f) {
+      while (first < last) {
+        unpack_chunk_position position = unpack_locate_row(first);
+        std::size_t rows = std::min(unpack_chunk_rows(position.chunk) - position.offset,
+            last - first);
+        f(make_tuple_vec_iter(_data, [position](auto& cur_col) {
+          return cur_col.chunk(position.chunk) + position.offset;
+        }), rows);
+        first += rows;
+      }
+    }
+
+    void publish(std::size_t first, std::size_t last) {
+      while (_size.load(std::memory_order_acquire) != first) {
+        std::this_thread::yield();
+      }
+      _size.store(last, std::memory_order_release);
+    }
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = unpack_iterator<typename types::iters_type>;
+    using const_iterator = unpack_const_iterator<typename types::const_iters_type>;
+
+    concurrent_vector() : _reserved(0), _size(0) {}
+
+    concurrent_vector(const concurrent_vector&) = delete;
+    concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+    ~concurrent_vector() {
+      clear();
+    }
+
+    // Rows published so far.
+    std::size_t size() const {
+      return _size.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+      return size() == 0;
+    }
+
+    // Appends row and returns its index. Safe to call from any number of
+    // threads at once.
+    std::size_t push_back(const T& row) {
+      return append(&row, &row + 1);
+    }
+
+    // Appends the rows of [first, last) as one contiguous range and returns
+    // the index of the first. Safe to call from any number of threads at
+    // once; dereferencing the iterators must not throw.
+    template <typename Iterator>
+    std::size_t append(Iterator first, Iterator last) {
+      std::size_t rows = std::distance(first, last);
+      std::size_t begin = _reserved.fetch_add(rows, std::memory_order_relaxed);
+      for_each_part(begin, begin + rows, [&first](auto columns, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++, ++first) {
+          tuple_for_each([i](auto* cur_data, auto& cur_elem) {
+            using X = typename std::remove_pointer<decltype(cur_data)>::type;
+            ::new (static_cast<void*>(cur_data + i)) X(cur_elem);
+          }, columns, *first);
+        }
+      });
+      publish(begin, begin + rows);
+      return begin;
+    }
+
+    // Not thread safe: no producer may be appending.
+    void clear() {
+      std::size_t size = _reserved.load(std::memory_order_relaxed);
+      tuple_for_each([size](auto& cur_col) { cur_col.destroy(0, size); }, _data);
+      _reserved.store(0, std::memory_order_relaxed);
+      _size.store(0, std::memory_order_release);
+    }
+
+    tuple_refs_type operator[](std::size_t index) {
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_const_refs_type operator[](std::size_t index) const {
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_refs_type at(std::size_t index) {
+      throw_if_out_of_bounds(index, size());
+      return operator[](index);
+    }
+
+    tuple_const_refs_type at(std::size_t index) const {
+      throw_if_out_of_bounds(index, size());
+      return operator[](index);
+    }
+
+    // Iterators over the rows published when end() is called.
+    iterator begin() {
+      return make_iterator(0);
+    }
+
+    iterator end() {
+      return make_iterator(size());
+    }
+
+    const_iterator begin() const {
+      return make_const_iterator(0);
+    }
+
+    const_iterator end() const {
+      return make_const_iterator(size());
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+    template <std::size_t N>
+    auto begin() const {
+      return make_column_iterator<N>(0);
+    }
+
+    template <std::size_t N>
+    auto end() const {
+      return make_column_iterator<N>(size());
+    }
+
+    // Calls f(data, rows) for the contiguous parts of column N holding the
+    // first `size` published rows, size() if 0, in row order.
+    template <std::size_t N, typename F>
+    void for_each_chunk(F&& f, std::size_t size = 0) const {
+      size = size ? size : this->size();
+      for (std::size_t first = 0; first < size; ) {
+        unpack_chunk_position position = unpack_locate_row(first);
+        std::size_t rows = std::min(unpack_chunk_rows(position.chunk), size - first);
+        f(static_cast<const typename std::tuple_element<N, T>::type*>(
+              std::get<N>(_data).existing_chunk(position.chunk)), rows);
+        first += rows;
+      }
+    }
+
+  private:
+    iterator make_iterator(std::size_t index) {
+      return iterator(make_tuple_vec_iter(_data, [index](auto& cur_col) {
+        using X = typename std::remove_reference<decltype(cur_col[0])>::type;
+        return unpack_concurrent_iterator<X>(&cur_col, index);
+      }));
+    }
+
+    const_iterator make_const_iterator(std::size_t index) const {
+      return const_iterator(make_tuple_vec_const_iter(_data, [index](auto& cur_col) {
+        using X = typename std::remove_reference<decltype(cur_col[0])>::type;
+        return unpack_concurrent_iterator<const X>(&cur_col, index);
+      }));
+    }
+
+    template <std::size_t N>
+    auto make_column_iterator(std::size_t index) const {
+      return unpack_concurrent_iterator<const typename std::tuple_element<N, T>::type>(
+          &std::get<N>(_data), index);
+    }
+};
+
+#endif
@@ -0,0 +1,608 @@
+#ifndef UNPACK_DEQUE
+#define UNPACK_DEQUE
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "unpack_details.hpp"
+#include "unpack_iterator.hpp"
+
+// Rows per segment of a deque<unpack<T>>, as a power of two. Every column
+// uses the same row count, so row i sits at the same segment and offset in
+// each column and one shift and mask locate it everywhere.
+constexpr std::size_t unpack_deque_segment_shift = 10;
+constexpr std::size_t unpack_deque_segment_rows = std::size_t(1) << unpack_deque_segment_shift;
+
+// Iterator over one column of a deque<unpack<T>>: the segment table of the
+// column and the position of the element counted from the start of the
+// first segment. Invalidated, like std::deque iterators, when rows are
+// added or removed at either end.
+template <typename X>
+class unpack_deque_iterator {
+  private:
+    X* const* _segments;
+    std::ptrdiff_t _index;
+
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = typename std::remove_const<X>::type;
+    using pointer = X*;
+    using reference = X&;
+    using iterator_category = std::random_access_iterator_tag;
+
+    unpack_deque_iterator() : _segments(nullptr), _index(0) {}
+
+    unpack_deque_iterator(X* const* segments, std::ptrdiff_t index)
+      : _segments(segments), _index(index)
+    {
+    }
+
+    reference operator*() const {
+      return _segments[_index >> unpack_deque_segment_shift]
+        [_index & (unpack_deque_segment_rows - 1)];
+    }
+
+    pointer operator->() const {
+      return &operator*();
+    }
+
+    reference operator[](difference_type dt) const {
+      return *(*this + dt);
+    }
+
+    unpack_deque_iterator& operator++() {
+      _index++;
+      return *this;
+    }
+
+    unpack_deque_iterator operator++(int) {
+      auto it = *this;
+      _index++;
+      return it;
+    }
+
+    unpack_deque_iterator& operator--() {
+      _index--;
+      return *this;
+    }
+
+    unpack_deque_iterator operator--(int) {
+      auto it = *this;
+      _index--;
+      return it;
+    }
+
+    unpack_deque_iterator& operator+=(difference_type dt) {
+      _index += dt;
+      return *this;
+    }
+
+    unpack_deque_iterator& operator-=(difference_type dt) {
+      _index -= dt;
+      return *this;
+    }
+
+    unpack_deque_iterator operator+(difference_type dt) const {
+      return unpack_deque_iterator(_segments, _index + dt);
+    }
+
+    unpack_deque_iterator operator-(difference_type dt) const {
+      return unpack_deque_iterator(_segments, _index - dt);
+    }
+
+    difference_type operator-(const unpack_deque_iterator& rhs) const {
+      return _index - rhs._index;
+    }
+
+    bool operator==(const unpack_deque_iterator& rhs) const {
+      return _index == rhs._index;
+    }
+
+    bool operator!=(const unpack_deque_iterator& rhs) const {
+      return _index != rhs._index;
+    }
+
+    bool operator<(const unpack_deque_iterator& rhs) const {
+      return _index < rhs._index;
+    }
+
+    bool operator<=(const unpack_deque_iterator& rhs) const {
+      return _index <= rhs._index;
+    }
+
+    bool operator>(const unpack_deque_iterator& rhs) const {
+      return _index > rhs._index;
+    }
+
+    bool operator>=(const unpack_deque_iterator& rhs) const {
+      return _index >= rhs._index;
+    }
+
+    friend unpack_deque_iterator operator+(difference_type dt, const unpack_deque_iterator& it) {
+      return it + dt;
+    }
+};
+
+// One column of a deque<unpack<T>>: a table of segments of
+// unpack_deque_segment_rows elements each. Growing adds segments and never
+// moves elements; only the table of segment pointers is reallocated. The
+// column only manages segments, the deque constructs and destroys elements.
+template <typename X>
+class unpack_deque_column {
+  private:
+    std::vector<X*> _segments;
+
+    static X* allocate() {
+      return std::allocator<X>().allocate(unpack_deque_segment_rows);
+    }
+
+    static void deallocate(X* segment) {
+      std::allocator<X>().deallocate(segment, unpack_deque_segment_rows);
+    }
+
+  public:
+    unpack_deque_column() {}
+
+    unpack_deque_column(const unpack_deque_column&) = delete;
+
+    unpack_deque_column(unpack_deque_column&& c) : _segments(std::move(c._segments)) {
+      c._segments.clear();
+    }
+
+    unpack_deque_column& operator=(const unpack_deque_column&) = delete;
+
+    unpack_deque_column& operator=(unpack_deque_column&& c) {
+      std::swap(_segments, c._segments);
+      return *this;
+    }
+
+    ~unpack_deque_column() {
+      keep_back(0);
+    }
+
+    std::size_t segments() const {
+      return _segments.size();
+    }
+
+    X* const* segment_table() const {
+      return _segments.data();
+    }
+
+    X& operator[](std::size_t index) {
+      return _segments[index >> unpack_deque_segment_shift]
+        [index & (unpack_deque_segment_rows - 1)];
+    }
+
+    const X& operator[](std::size_t index) const {
+      return _segments[index >> unpack_deque_segment_shift]
+        [index & (unpack_deque_segment_rows - 1)];
+    }
+
+    // Adds segments at the back until there are at least `segments`.
+    void reserve_back(std::size_t segments) {
+      _segments.reserve(segments);
+      while (_segments.size() < segments) {
+        _segments.push_back(allocate());
+      }
+    }
+
+    // Releases segments at the back until there are at most `segments`.
+    void keep_back(std::size_t segments) {
+      while (_segments.size() > segments) {
+        deallocate(_segments.back());
+        _segments.pop_back();
+      }
+    }
+
+    void add_front() {
+      _segments.reserve(_segments.size() + 1);
+      _segments.insert(_segments.begin(), allocate());
+    }
+
+    void drop_front() {
+      deallocate(_segments.front());
+      _segments.erase(_segments.begin());
+    }
+
+    void swap(unpack_deque_column& c) {
+      _segments.swap(c._segments);
+    }
+};
+
+template <typename T, typename Indices>
+struct deque_types_helper;
+
+template <typename T, std::size_t ... Indices>
+struct deque_types_helper<T, std::index_sequence<Indices ...>> {
+  using data_type = std::tuple<unpack_deque_column<typename std::tuple_element<Indices, T>::type> ...>;
+  using iters_type = std::tuple<
+    unpack_deque_iterator<typename std::tuple_element<Indices, T>::type> ...>;
+  using const_iters_type = std::tuple<
+    unpack_deque_iterator<const typename std::tuple_element<Indices, T>::type> ...>;
+};
+
+template <typename T>
+struct deque_types {
+  using Indices = std::make_index_sequence<std::tuple_size<T>::value>;
+  using data_type = typename deque_types_helper<T, Indices>::data_type;
+  using iters_type = typename deque_types_helper<T, Indices>::iters_type;
+  using const_iters_type = typename deque_types_helper<T, Indices>::const_iters_type;
+};
+
+namespace std
+{
+
+// Segmented counterpart of vector<unpack<T>>. Each column is a table of
+// fixed size segments, all columns holding the same rows in the same
+// segment, so push_back and push_front never move existing elements and
+// growth never copies them: appending to a large table costs the same at
+// every size, without the copy at each doubling of a vector. References to
+// elements stay valid across pushes and pops at the other end.
+template <typename T>
+class deque<unpack<T>> {
+  private:
+    using types = deque_types<T>;
+    using tuple_refs_type = typename unpack_tuple_refs_type<T>::type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+    typename types::data_type _data;
+    // Position of the first row in the first segment, below
+    // unpack_deque_segment_rows.
+    size_t _start;
+    size_t _size;
+
+    static size_t segments_for(size_t rows) {
+      return (rows + unpack_deque_segment_rows - 1) >> unpack_deque_segment_shift;
+    }
+
+    // Makes room for `rows` rows past the last one.
+    void grow_back(size_t rows) {
+      size_t segments = segments_for(_start + _size + rows);
+      tuple_for_each([segments](auto& cur_col) { cur_col.reserve_back(segments); }, _data);
+    }
+
+    // Adds a segment in front of every column, so that there is room for
+    // unpack_deque_segment_rows rows before the first one.
+    void grow_front() {
+      size_t added = 0;
+      try {
+        tuple_for_each([&added](auto& cur_col) {
+          cur_col.add_front();
+          added++;
+        }, _data);
+      } catch (...) {
+        tuple_for_each([&added](auto& cur_col) {
+          if (added) {
+            cur_col.drop_front();
+            added--;
+          }
+        }, _data);
+        throw;
+      }
+      _start += unpack_deque_segment_rows;
+    }
+
+    // Releases the segments no row lives in anymore.
+    void release() {
+      if (_size == 0) {
+        tuple_for_each([](auto& cur_col) { cur_col.keep_back(0); }, _data);
+        _start = 0;
+        return;
+      }
+      size_t segments = segments_for(_start + _size);
+      tuple_for_each([segments](auto& cur_col) { cur_col.keep_back(segments); }, _data);
+      while (_start >= unpack_deque_segment_rows) {
+        tuple_for_each([](auto& cur_col) { cur_col.drop_front(); }, _data);
+        _start -= unpack_deque_segment_rows;
+      }
+    }
+
+    // Constructs the elements at index from the matching members of values.
+    template <typename Values>
+    void construct(size_t index, Values&& values) {
+      tuple_for_each([index](auto& cur_col, auto&& value) {
+        using X = typename std::remove_reference<decltype(cur_col[0])>::type;
+        ::new (static_cast<void*>(&cur_col[index])) X(std::forward<decltype(value)>(value));
+      }, _data, std::forward<Values>(values));
+    }
+
+    void destroy(size_t first, size_t last) {
+      tuple_for_each([first, last](auto& cur_col) {
+        using X = typename std::remove_reference<decltype(cur_col[0])>::type;
+        for (size_t i = first; i < last; i++) {
+          cur_col[i].~X();
+        }
+      }, _data);
+    }
+
+    template <typename Iterator>
+    void append(Iterator first, Iterator last) {
+      grow_back(std::distance(first, last));
+      for (; first != last; ++first) {
+        push_back(*first);
+      }
+    }
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = unpack_iterator<typename types::iters_type>;
+    using const_iterator = unpack_const_iterator<typename types::const_iters_type>;
+
+    deque() : _start(0), _size(0) {}
+
+    explicit deque(size_t size) : deque() {
+      resize(size);
+    }
+
+    deque(size_t size, const T& value) : deque() {
+      resize(size, value);
+    }
+
+    deque(std::initializer_list<T> ilist) : deque() {
+      append(ilist.begin(), ilist.end());
+    }
+
+    deque(const deque& d) : deque() {
+      append(d.begin(), d.end());
+    }
+
+    deque(deque&& d) : _data(std::move(d._data)), _start(d._start), _size(d._size) {
+      d._start = 0;
+      d._size = 0;
+    }
+
+    deque& operator=(const deque& d) {
+      if (this != &d) {
+        clear();
+        append(d.begin(), d.end());
+      }
+      return *this;
+    }
+
+    deque& operator=(deque&& d) {
+      if (this != &d) {
+        clear();
+        swap(d);
+      }
+      return *this;
+    }
+
+    ~deque() {
+      clear();
+    }
+
+    size_t size() const {
+      return _size;
+    }
+
+    bool empty() const {
+      return _size == 0;
+    }
+
+    // Segments allocated per column.
+    size_t segments() const {
+      return std::get<0>(_data).segments();
+    }
+
+    void clear() {
+      destroy(_start, _start + _size);
+      _size = 0;
+      release();
+    }
+
+    void shrink_to_fit() {
+      release();
+    }
+
+    void push_back(const T& elem) {
+      grow_back(1);
+      construct(_start + _size, elem);
+      _size++;
+    }
+
+    template <typename ... Args>
+    tuple_refs_type emplace_back(Args&& ... args) {
+      grow_back(1);
+      construct(_start + _size, std::forward_as_tuple(std::forward<Args>(args) ...));
+      _size++;
+      return back();
+    }
+
+    void push_front(const T& elem) {
+      if (_start == 0) {
+        grow_front();
+      }
+      construct(_start - 1, elem);
+      _start--;
+      _size++;
+    }
+
+    template <typename ... Args>
+    tuple_refs_type emplace_front(Args&& ... args) {
+      if (_start == 0) {
+        grow_front();
+      }
+      construct(_start - 1, std::forward_as_tuple(std::forward<Args>(args) ...));
+      _start--;
+      _size++;
+      return front();
+    }
+
+    void pop_back() {
+      destroy(_start + _size - 1, _start + _size);
+      _size--;
+      release();
+    }
+
+    void pop_front() {
+      destroy(_start, _start + 1);
+      _start++;
+      _size--;
+      release();
+    }
+
+    void resize(size_t size) {
+      if (size < _size) {
+        destroy(_start + size, _start + _size);
+        _size = size;
+        release();
+        return;
+      }
+      grow_back(size - _size);
+      size_t first = _start + _size;
+      size_t last = _start + size;
+      tuple_for_each([first, last](auto& cur_col) {
+        using X = typename std::remove_reference<decltype(cur_col[0])>::type;
+        for (size_t i = first; i < last; i++) {
+          ::new (static_cast<void*>(&cur_col[i])) X();
+        }
+      }, _data);
+      _size = size;
+    }
+
+    void resize(size_t size, const T& value) {
+      if (size < _size) {
+        resize(size);
+        return;
+      }
+      grow_back(size - _size);
+      while (_size < size) {
+        push_back(value);
+      }
+    }
+
+    void swap(deque& d) {
+      tuple_for_each([](auto& cur_col, auto& target_cur_col) {
+        cur_col.swap(target_cur_col);
+      }, _data, d._data);
+      std::swap(_start, d._start);
+      std::swap(_size, d._size);
+    }
+
+    tuple_refs_type operator[](size_t index) {
+      return tuple_r_at_index(_data, _start + index);
+    }
+
+    tuple_const_refs_type operator[](size_t index) const {
+      return tuple_r_at_index(_data, _start + index);
+    }
+
+    tuple_refs_type at(size_t index) {
+      throw_if_out_of_bounds(index, _size);
+      return operator[](index);
+    }
+
+    tuple_const_refs_type at(size_t index) const {
+      throw_if_out_of_bounds(index, _size);
+      return operator[](index);
+    }
+
+    tuple_refs_type front() {
+      return operator[](0);
+    }
+
+    tuple_const_refs_type front() const {
+      return operator[](0);
+    }
+
+    tuple_refs_type back() {
+      return operator[](_size - 1);
+    }
+
+    tuple_const_refs_type back() const {
+      return operator[](_size - 1);
+    }
+
+    iterator begin() {
+      size_t index = _start;
+      return iterator(make_tuple_vec_iter(_data, [index](auto& cur_col) {
+            return make_column_iterator(cur_col, index); }));
+    }
+
+    iterator end() {
+      size_t index = _start + _size;
+      return iterator(make_tuple_vec_iter(_data, [index](auto& cur_col) {
+            return make_column_iterator(cur_col, index); }));
+    }
+
+    const_iterator begin() const {
+      size_t index = _start;
+      return const_iterator(make_tuple_vec_const_iter(_data, [index](auto& cur_col) {
+            return make_column_iterator(cur_col, index); }));
+    }
+
+    const_iterator end() const {
+      size_t index = _start + _size;
+      return const_iterator(make_tuple_vec_const_iter(_data, [index](auto& cur_col) {
+            return make_column_iterator(cur_col, index); }));
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+    template <size_t N>
+    auto begin() {
+      return make_column_iterator(std::get<N>(_data), _start);
+    }
+
+    template <size_t N>
+    auto end() {
+      return make_column_iterator(std::get<N>(_data), _start + _size);
+    }
+
+    template <size_t N>
+    auto begin() const {
+      return make_column_iterator(std::get<N>(_data), _start);
+    }
+
+    template <size_t N>
+    auto end() const {
+      return make_column_iterator(std::get<N>(_data), _start + _size);
+    }
+
+    friend void swap(deque& lhs, deque& rhs) {
+      lhs.swap(rhs);
+    }
+
+  private:
+    template <typename X>
+    static unpack_deque_iterator<X> make_column_iterator(unpack_deque_column<X>& col,
+        size_t index) {
+      return unpack_deque_iterator<X>(col.segment_table(), index);
+    }
+
+    template <typename X>
+    static unpack_deque_iterator<const X> make_column_iterator(
+        const unpack_deque_column<X>& col, size_t index) {
+      return unpack_deque_iterator<const X>(col.segment_table(), index);
+    }
+};
+
+template <typename T>
+bool operator==(const deque<unpack<T>>& lhs, const deque<unpack<T>>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T>
+bool operator!=(const deque<unpack<T>>& lhs, const deque<unpack<T>>& rhs) {
+  return !(lhs == rhs);
+}
+
+}
+
+#endif
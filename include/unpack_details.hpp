@@ -1,16 +1,87 @@
 #ifndef UNPACK_DETAILS
 #define UNPACK_DETAILS
 
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// Allocator of the column vectors. It only differs from std::allocator in
+// that constructing a trivially default constructible element without
+// arguments default-initializes it, so growing such a column with
+// resize(n) leaves the new elements unwritten. vector<unpack<T>> passes an
+// explicit value wherever it promises value-initialization.
+template <typename X>
+class unpack_allocator {
+  private:
+    template <typename U>
+    static void construct_default(U* p, std::true_type) {
+      ::new (static_cast<void*>(p)) U;
+    }
+
+    template <typename U>
+    static void construct_default(U* p, std::false_type) {
+      ::new (static_cast<void*>(p)) U();
+    }
+
+  public:
+    using value_type = X;
+
+    unpack_allocator() = default;
+
+    template <typename U>
+    unpack_allocator(const unpack_allocator<U>&) {}
+
+    X* allocate(std::size_t n) {
+      return std::allocator<X>().allocate(n);
+    }
+
+    void deallocate(X* p, std::size_t n) {
+      std::allocator<X>().deallocate(p, n);
+    }
+
+    template <typename U>
+    void construct(U* p) {
+      construct_default(p, std::is_trivially_default_constructible<U>());
+    }
+
+    template <typename U, typename ... Args>
+    void construct(U* p, Args&& ... args) {
+      ::new (static_cast<void*>(p)) U(std::forward<Args>(args) ...);
+    }
+};
+
+template <typename X, typename U>
+bool operator==(const unpack_allocator<X>&, const unpack_allocator<U>&) {
+  return true;
+}
+
+template <typename X, typename U>
+bool operator!=(const unpack_allocator<X>&, const unpack_allocator<U>&) {
+  return false;
+}
+
+template <typename X>
+using unpack_column_vector = std::vector<X, unpack_allocator<X>>;
+
+// Selects default-initialization of new rows in vector<unpack<T>>(size,
+// unpack_default_init) and resize(size, unpack_default_init).
+struct unpack_default_init_t {};
+
+constexpr unpack_default_init_t unpack_default_init = unpack_default_init_t();
+
 template <typename T, typename Indices>
 struct inversion_helper;
 
 template <typename T, size_t ... Indices>
 struct inversion_helper<T, std::index_sequence<Indices ...>> {
   using type = std::tuple<
-          std::vector<typename std::tuple_element<Indices, T>::type> ...
+          unpack_column_vector<typename std::tuple_element<Indices, T>::type> ...
          >;
 };
 
@@ -20,6 +91,29 @@ struct unpack_inversion {
   using type = typename inversion_helper<T, Indices>::type; 
 };
 
+template <typename T, typename Indices>
+struct row_bytes_helper;
+
+template <typename T, size_t ... Indices>
+struct row_bytes_helper<T, std::index_sequence<Indices ...>> {
+  static constexpr std::size_t sum(std::initializer_list<std::size_t> sizes) {
+    std::size_t total = 0;
+    for (std::size_t size : sizes) {
+      total += size;
+    }
+    return total;
+  }
+
+  static constexpr std::size_t value = sum({ sizeof(typename std::tuple_element<Indices, T>::type) ... });
+};
+
+// Bytes of one row of T, summed over its columns.
+template <typename T>
+struct unpack_row_bytes {
+  using Indices = std::make_index_sequence<std::tuple_size<T>::value>;
+  static constexpr std::size_t value = row_bytes_helper<T, Indices>::value;
+};
+
 template <typename T, typename Indices>
 struct tuple_refs_type_helper;
 
@@ -58,7 +152,7 @@ struct tuple_vec_iter_type_helper;
 template <typename T, size_t ... Indices>
 struct tuple_vec_iter_type_helper<T, std::index_sequence<Indices ...>> {
   using type = std::tuple<
-    typename std::vector<typename std::tuple_element<Indices, T>::type>::iterator ... 
+    typename unpack_column_vector<typename std::tuple_element<Indices, T>::type>::iterator ...
          >;
 };
 
@@ -74,7 +168,7 @@ struct tuple_vec_const_iter_type_helper;
 template <typename T, size_t ... Indices>
 struct tuple_vec_const_iter_type_helper<T, std::index_sequence<Indices ...>> {
   using type = std::tuple<
-          typename std::vector<typename std::tuple_element<Indices, T>::type>::const_iterator ... 
+          typename unpack_column_vector<typename std::tuple_element<Indices, T>::type>::const_iterator ...
          >;
 };
 
@@ -137,7 +231,8 @@ struct remove_iter_type_helper;
 template <typename TupleItersType, std::size_t...Indices> 
 struct remove_iter_type_helper<TupleItersType, std::index_sequence<Indices...>>
 {
-  using type = std::tuple<typename std::tuple_element<Indices, TupleItersType>::type::value_type...>;
+  using type = std::tuple<typename std::iterator_traits<
+    typename std::tuple_element<Indices, TupleItersType>::type>::value_type...>;
 };
 
 template <typename TupleItersType>
@@ -0,0 +1,207 @@
+#ifndef UNPACK_EXPRESSION
+#define UNPACK_EXPRESSION
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "unpack_simd.hpp"
+
+// Base of every lazy column expression. E provides operator[](i), the value
+// of the expression for row i, and has_size(n), whether every column it
+// reads holds n rows. Nothing is computed until the expression is assigned
+// to a column, which then runs a single pass over all rows.
+template <typename E>
+struct unpack_expression {
+  const E& self() const {
+    return static_cast<const E&>(*this);
+  }
+};
+
+template <typename T>
+class unpack_scalar : public unpack_expression<unpack_scalar<T>> {
+  private:
+    T _value;
+
+  public:
+    explicit unpack_scalar(const T& value) : _value(value) {}
+
+    const T& operator[](std::size_t) const {
+      return _value;
+    }
+
+    bool has_size(std::size_t) const {
+      return true;
+    }
+};
+
+// Operands are held by value: columns are a pointer and a size, and inner
+// nodes are usually temporaries of the full expression.
+template <typename Op, typename E>
+class unpack_unary_expression : public unpack_expression<unpack_unary_expression<Op, E>> {
+  private:
+    E _operand;
+
+  public:
+    explicit unpack_unary_expression(const E& operand) : _operand(operand) {}
+
+    auto operator[](std::size_t index) const {
+      return Op()(_operand[index]);
+    }
+
+    bool has_size(std::size_t size) const {
+      return _operand.has_size(size);
+    }
+};
+
+template <typename Op, typename L, typename R>
+class unpack_binary_expression
+  : public unpack_expression<unpack_binary_expression<Op, L, R>> {
+  private:
+    L _lhs;
+    R _rhs;
+
+  public:
+    unpack_binary_expression(const L& lhs, const R& rhs) : _lhs(lhs), _rhs(rhs) {}
+
+    auto operator[](std::size_t index) const {
+      return Op()(_lhs[index], _rhs[index]);
+    }
+
+    bool has_size(std::size_t size) const {
+      return _lhs.has_size(size) && _rhs.has_size(size);
+    }
+};
+
+// A column of a vector<unpack<T>>, see vector::col<N>(). Copying the
+// column copies the view; assigning to it writes every row.
+template <typename T>
+class unpack_column : public unpack_expression<unpack_column<T>> {
+  private:
+    T* _data;
+    std::size_t _size;
+
+    template <typename E>
+    void throw_if_size_mismatch(const E& e) const {
+      if (!e.has_size(_size)) {
+        throw std::length_error("unpack_column: expression size does not match column size");
+      }
+    }
+
+    void fill(const T& value) {
+      UNPACK_COLUMN_DISPATCH(simd_runtime_level(), fill, _data, _size, value)
+    }
+
+  public:
+    using value_type = typename std::remove_const<T>::type;
+
+    unpack_column(T* data, std::size_t size) : _data(data), _size(size) {}
+
+    unpack_column(const unpack_column&) = default;
+
+    T& operator[](std::size_t index) const {
+      return _data[index];
+    }
+
+    T* data() const {
+      return _data;
+    }
+
+    std::size_t size() const {
+      return _size;
+    }
+
+    bool has_size(std::size_t size) const {
+      return _size == size;
+    }
+
+    // Writes e[i] to rows [first, last) in one vectorized pass. The caller
+    // is responsible for the bounds, see operator=.
+    template <typename E>
+    void assign(std::size_t first, std::size_t last, const E& e) const {
+      UNPACK_COLUMN_DISPATCH(simd_runtime_level(), assign, _data, first, last, e)
+    }
+
+    template <typename E>
+    unpack_column& operator=(const unpack_expression<E>& e) {
+      throw_if_size_mismatch(e.self());
+      assign(0, _size, e.self());
+      return *this;
+    }
+
+    unpack_column& operator=(const unpack_column& c) {
+      return operator=(static_cast<const unpack_expression<unpack_column>&>(c));
+    }
+
+    unpack_column& operator=(const value_type& value) {
+      fill(value);
+      return *this;
+    }
+
+    template <typename E>
+    unpack_column& operator+=(const unpack_expression<E>& e);
+    template <typename E>
+    unpack_column& operator-=(const unpack_expression<E>& e);
+    template <typename E>
+    unpack_column& operator*=(const unpack_expression<E>& e);
+    template <typename E>
+    unpack_column& operator/=(const unpack_expression<E>& e);
+
+    unpack_column& operator+=(const value_type& value) {
+      return operator+=(unpack_scalar<value_type>(value));
+    }
+
+    unpack_column& operator-=(const value_type& value) {
+      return operator-=(unpack_scalar<value_type>(value));
+    }
+
+    unpack_column& operator*=(const value_type& value) {
+      return operator*=(unpack_scalar<value_type>(value));
+    }
+
+    unpack_column& operator/=(const value_type& value) {
+      return operator/=(unpack_scalar<value_type>(value));
+    }
+};
+
+template <typename T>
+using if_unpack_scalar_t = typename std::enable_if<std::is_arithmetic<T>::value>::type;
+
+#define UNPACK_EXPRESSION_OPERATOR(op, functor) \
+  template <typename L, typename R> \
+  unpack_binary_expression<functor, L, R> operator op( \
+      const unpack_expression<L>& lhs, const unpack_expression<R>& rhs) { \
+    return unpack_binary_expression<functor, L, R>(lhs.self(), rhs.self()); \
+  } \
+  template <typename L, typename S, typename = if_unpack_scalar_t<S>> \
+  unpack_binary_expression<functor, L, unpack_scalar<S>> operator op( \
+      const unpack_expression<L>& lhs, const S& rhs) { \
+    return unpack_binary_expression<functor, L, unpack_scalar<S>>( \
+        lhs.self(), unpack_scalar<S>(rhs)); \
+  } \
+  template <typename S, typename R, typename = if_unpack_scalar_t<S>> \
+  unpack_binary_expression<functor, unpack_scalar<S>, R> operator op( \
+      const S& lhs, const unpack_expression<R>& rhs) { \
+    return unpack_binary_expression<functor, unpack_scalar<S>, R>( \
+        unpack_scalar<S>(lhs), rhs.self()); \
+  } \
+  template <typename T> \
+  template <typename E> \
+  unpack_column<T>& unpack_column<T>::operator op##=(const unpack_expression<E>& e) { \
+    return operator=(*this op e); \
+  }
+
+UNPACK_EXPRESSION_OPERATOR(+, std::plus<>)
+UNPACK_EXPRESSION_OPERATOR(-, std::minus<>)
+UNPACK_EXPRESSION_OPERATOR(*, std::multiplies<>)
+UNPACK_EXPRESSION_OPERATOR(/, std::divides<>)
+
+#undef UNPACK_EXPRESSION_OPERATOR
+
+template <typename E>
+unpack_unary_expression<std::negate<>, E> operator-(const unpack_expression<E>& e) {
+  return unpack_unary_expression<std::negate<>, E>(e.self());
+}
+
+#endif
@@ -0,0 +1,355 @@
+#ifndef UNPACK_GROUP_BY
+#define UNPACK_GROUP_BY
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "unpack_hash.hpp"
+#include "unpack_parallel.hpp"
+#include "unpack_query.hpp"
+#include "unpack_vector.hpp"
+
+// Rows hashed and inserted per batch.
+constexpr std::size_t unpack_group_batch_rows = 4096;
+
+// Aggregate operations for group_by(...).aggregate(...). Each keeps one
+// state per group, updated with every value of the group and turned into
+// the output value by finish.
+struct group_sum {
+  template <typename X> using state = unpack_sum_t<X>;
+  template <typename X> using result = unpack_sum_t<X>;
+
+  template <typename X>
+  state<X> init() const {
+    return state<X>();
+  }
+
+  template <typename S, typename X>
+  void update(S& s, const X& x) const {
+    s += x;
+  }
+
+  template <typename S>
+  S finish(const S& s) const {
+    return s;
+  }
+};
+
+struct group_count {
+  template <typename X> using state = std::size_t;
+  template <typename X> using result = std::size_t;
+
+  template <typename X>
+  state<X> init() const {
+    return 0;
+  }
+
+  template <typename X>
+  void update(std::size_t& s, const X&) const {
+    s++;
+  }
+
+  std::size_t finish(std::size_t s) const {
+    return s;
+  }
+};
+
+struct group_min {
+  template <typename X> using state = X;
+  template <typename X> using result = X;
+
+  template <typename X>
+  state<X> init() const {
+    return std::numeric_limits<X>::max();
+  }
+
+  template <typename X>
+  void update(X& s, const X& x) const {
+    s = x < s ? x : s;
+  }
+
+  template <typename X>
+  X finish(const X& s) const {
+    return s;
+  }
+};
+
+struct group_max {
+  template <typename X> using state = X;
+  template <typename X> using result = X;
+
+  template <typename X>
+  state<X> init() const {
+    return std::numeric_limits<X>::lowest();
+  }
+
+  template <typename X>
+  void update(X& s, const X& x) const {
+    s = s < x ? x : s;
+  }
+
+  template <typename X>
+  X finish(const X& s) const {
+    return s;
+  }
+};
+
+struct group_mean {
+  template <typename X> using state = std::pair<double, std::size_t>;
+  template <typename X> using result = double;
+
+  template <typename X>
+  state<X> init() const {
+    return { 0.0, 0 };
+  }
+
+  template <typename X>
+  void update(std::pair<double, std::size_t>& s, const X& x) const {
+    s.first += x;
+    s.second++;
+  }
+
+  double finish(const std::pair<double, std::size_t>& s) const {
+    return s.first / s.second;
+  }
+};
+
+template <typename T, typename Keys, typename Values, typename ... Ops>
+class unpack_group_table;
+
+// Open addressing hash table from the key columns Keys of a vector<unpack<T>>
+// to the aggregate states of its value columns Values. Slots only hold group
+// numbers. The keys, hashes and states of the groups are kept in separate
+// arrays, the keys and states as unpack vectors, so probing touches one
+// 4 byte slot and updating a state touches only that state's column.
+template <typename T, std::size_t ... Keys, std::size_t ... Values, typename ... Ops>
+class unpack_group_table<T, std::index_sequence<Keys ...>, std::index_sequence<Values ...>,
+      Ops ...> {
+  public:
+    using key_type = std::tuple<typename std::tuple_element<Keys, T>::type ...>;
+    using state_type = std::tuple<
+      typename Ops::template state<typename std::tuple_element<Values, T>::type> ...>;
+    using result_type = std::tuple<typename std::tuple_element<Keys, T>::type ...,
+      typename Ops::template result<typename std::tuple_element<Values, T>::type> ...>;
+
+  private:
+    static constexpr std::size_t key_count = sizeof...(Keys);
+    const std::vector<unpack<T>>& _v;
+    std::tuple<Ops ...> _ops;
+    std::vector<std::uint32_t> _slots;
+    std::vector<std::uint64_t> _hashes;
+    std::vector<unpack<key_type>> _keys;
+    std::vector<unpack<state_type>> _states;
+
+    static std::size_t row(const std::size_t* rows, std::size_t first, std::size_t i) {
+      return rows ? rows[i] : first + i;
+    }
+
+    template <std::size_t ... Indices>
+    bool keys_equal(std::size_t group, std::size_t r, std::index_sequence<Indices ...>) const {
+      bool equal = true;
+      using dummy = int[];
+      (void)dummy{1, (equal = equal
+          && _keys.template data<Indices>()[group] == _v.template data<Keys>()[r], int{})...};
+      return equal;
+    }
+
+    template <std::size_t ... Indices>
+    void add_group(std::size_t r, std::uint64_t h, std::index_sequence<Indices ...>) {
+      _hashes.push_back(h);
+      _keys.push_back(key_type(_v.template data<Keys>()[r] ...));
+      _states.push_back(state_type(std::get<Indices>(_ops)
+            .template init<typename std::tuple_element<Values, T>::type>() ...));
+    }
+
+    void place(std::uint32_t group) {
+      std::size_t mask = _slots.size() - 1;
+      std::size_t slot = _hashes[group] & mask;
+      while (_slots[slot]) {
+        slot = (slot + 1) & mask;
+      }
+      _slots[slot] = group + 1;
+    }
+
+    void grow() {
+      _slots.assign(_slots.size() * 2, 0);
+      for (std::uint32_t group = 0; group < _hashes.size(); group++) {
+        place(group);
+      }
+    }
+
+    template <std::size_t J, std::size_t N>
+    void update_column(const std::size_t* rows, std::size_t first, const std::uint32_t* group,
+        std::size_t n) {
+      auto s = _states.template data<J>();
+      auto p = _v.template data<N>();
+      auto& op = std::get<J>(_ops);
+      for (std::size_t i = 0; i < n; i++) {
+        op.update(s[group[i]], p[row(rows, first, i)]);
+      }
+    }
+
+    template <std::size_t ... Indices>
+    void update(const std::size_t* rows, std::size_t first, const std::uint32_t* group,
+        std::size_t n, std::index_sequence<Indices ...>) {
+      using dummy = int[];
+      (void)dummy{1, (update_column<Indices, Values>(rows, first, group, n), int{})...};
+    }
+
+    template <typename R, std::size_t ... Indices>
+    void append_keys(R& result, std::size_t base, std::index_sequence<Indices ...>) const {
+      using dummy = int[];
+      (void)dummy{1, (std::copy(_keys.template begin<Indices>(), _keys.template end<Indices>(),
+            result.template data<Indices>() + base), int{})...};
+    }
+
+    template <typename R, std::size_t ... Indices>
+    void append_states(R& result, std::size_t base, std::index_sequence<Indices ...>) const {
+      using dummy = int[];
+      (void)dummy{1, (std::transform(_states.template begin<Indices>(),
+            _states.template end<Indices>(), result.template data<key_count + Indices>() + base,
+            [this](const auto& s) { return std::get<Indices>(_ops).finish(s); }), int{})...};
+    }
+
+  public:
+    unpack_group_table(const std::vector<unpack<T>>& v, const std::tuple<Ops ...>& ops)
+      : _v(v), _ops(ops), _slots(1024, 0)
+    {
+    }
+
+    std::size_t size() const {
+      return _hashes.size();
+    }
+
+    // Adds the given rows, whose key hashes are h, to their groups. rows ==
+    // nullptr stands for the rows [first, first + n).
+    void insert(const std::size_t* rows, std::size_t first, const std::uint64_t* h,
+        std::size_t n) {
+      std::vector<std::uint32_t> group(n);
+      for (std::size_t i = 0; i < n; i++) {
+        std::size_t r = row(rows, first, i);
+        std::size_t mask = _slots.size() - 1;
+        std::size_t slot = h[i] & mask;
+        while (true) {
+          std::uint32_t found = _slots[slot];
+          if (!found) {
+            group[i] = static_cast<std::uint32_t>(_hashes.size());
+            add_group(r, h[i], std::index_sequence_for<Ops ...>{});
+            _slots[slot] = group[i] + 1;
+            if (2 * _hashes.size() > _slots.size()) {
+              grow();
+            }
+            break;
+          }
+          if (_hashes[found - 1] == h[i]
+              && keys_equal(found - 1, r, std::make_index_sequence<key_count>{})) {
+            group[i] = found - 1;
+            break;
+          }
+          slot = (slot + 1) & mask;
+        }
+      }
+      update(rows, first, group.data(), n, std::index_sequence_for<Ops ...>{});
+    }
+
+    // Appends one row per group, keys then finished aggregates, to result.
+    void append_to(std::vector<unpack<result_type>>& result) const {
+      std::size_t base = result.size();
+      result.resize(base + size());
+      append_keys(result, base, std::make_index_sequence<key_count>{});
+      append_states(result, base, std::index_sequence_for<Ops ...>{});
+    }
+};
+
+// Grouping of a vector<unpack<T>> on key columns Keys, see group_by.
+template <typename T, std::size_t ... Keys>
+class unpack_group_by {
+  private:
+    const std::vector<unpack<T>>& _v;
+    std::size_t _threads;
+
+  public:
+    unpack_group_by(const std::vector<unpack<T>>& v, std::size_t threads)
+      : _v(v), _threads(threads)
+    {
+    }
+
+    // Returns one row per distinct key: the key columns followed by
+    // ops[i] applied to column Values[i] of the rows with that key.
+    // Serially, groups appear in order of first occurrence. In parallel,
+    // rows are first partitioned on their key hash, each partition is
+    // grouped by its own thread and table, and the partitions are
+    // concatenated.
+    template <std::size_t ... Values, typename ... Ops>
+    auto aggregate(Ops ... ops) const {
+      static_assert(sizeof...(Values) == sizeof...(Ops),
+          "group_by::aggregate needs one operation per value column");
+      using table_type = unpack_group_table<T, std::index_sequence<Keys ...>,
+            std::index_sequence<Values ...>, Ops ...>;
+      std::tuple<Ops ...> op_tuple(ops ...);
+      std::vector<unpack<typename table_type::result_type>> result;
+      std::vector<std::uint64_t> h(unpack_group_batch_rows);
+      if (_threads <= 1) {
+        table_type table(_v, op_tuple);
+        for (std::size_t first = 0; first < _v.size(); first += unpack_group_batch_rows) {
+          std::size_t n = std::min(unpack_group_batch_rows, _v.size() - first);
+          hash_columns<Keys ...>(_v, nullptr, first, n, h.data());
+          table.insert(nullptr, first, h.data(), n);
+        }
+        table.append_to(result);
+        return result;
+      }
+      std::size_t parts = _threads;
+      // rows[c][p] and hashes[c][p]: the rows of chunk c that fall in
+      // partition p, and their hashes.
+      std::vector<std::vector<std::vector<std::size_t>>> rows(parts,
+          std::vector<std::vector<std::size_t>>(parts));
+      std::vector<std::vector<std::vector<std::uint64_t>>> hashes(parts,
+          std::vector<std::vector<std::uint64_t>>(parts));
+      parallel_run(parts, _threads, [&](std::size_t c) {
+        std::vector<std::uint64_t> chunk_h(unpack_group_batch_rows);
+        std::size_t last = _v.size() * (c + 1) / parts;
+        for (std::size_t first = _v.size() * c / parts; first < last;
+            first += unpack_group_batch_rows) {
+          std::size_t n = std::min(unpack_group_batch_rows, last - first);
+          hash_columns<Keys ...>(_v, nullptr, first, n, chunk_h.data());
+          for (std::size_t i = 0; i < n; i++) {
+            std::size_t p = (chunk_h[i] >> 32) % parts;
+            rows[c][p].push_back(first + i);
+            hashes[c][p].push_back(chunk_h[i]);
+          }
+        }
+      });
+      std::vector<table_type> tables;
+      tables.reserve(parts);
+      for (std::size_t p = 0; p < parts; p++) {
+        tables.emplace_back(_v, op_tuple);
+      }
+      parallel_run(parts, _threads, [&](std::size_t p) {
+        for (std::size_t c = 0; c < parts; c++) {
+          tables[p].insert(rows[c][p].data(), 0, hashes[c][p].data(), rows[c][p].size());
+        }
+      });
+      for (auto& table : tables) {
+        table.append_to(result);
+      }
+      return result;
+    }
+};
+
+// Groups the rows of v on key columns Keys, e.g.
+// group_by<0>(v).aggregate<1, 2>(group_sum(), group_max()). With threads > 1
+// the aggregation is hash partitioned across threads. v must outlive the
+// returned object.
+template <std::size_t ... Keys, typename T>
+unpack_group_by<T, Keys ...> group_by(const std::vector<unpack<T>>& v, std::size_t threads = 1) {
+  return unpack_group_by<T, Keys ...>(v, threads);
+}
+
+#endif
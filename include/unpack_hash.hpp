@@ -0,0 +1,75 @@
+#ifndef UNPACK_HASH
+#define UNPACK_HASH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "unpack_vector.hpp"
+
+constexpr std::uint64_t unpack_hash_seed = 0x9e3779b97f4a7c15ULL;
+
+// Final mixing step of MurmurHash3.
+inline std::uint64_t unpack_hash_mix(std::uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+template <typename X, typename std::enable_if<std::is_integral<X>::value
+  || std::is_enum<X>::value, int>::type = 0>
+std::uint64_t unpack_hash_value(const X& x) {
+  return static_cast<std::uint64_t>(x);
+}
+
+template <typename X, typename std::enable_if<std::is_floating_point<X>::value, int>::type = 0>
+std::uint64_t unpack_hash_value(const X& x) {
+  // -0.0 and 0.0 compare equal, so they must hash equal.
+  X value = x == X() ? X() : x;
+  std::uint64_t bits = 0;
+  std::memcpy(&bits, &value, std::min(sizeof(X), sizeof(bits)));
+  return bits;
+}
+
+template <typename X, typename std::enable_if<!std::is_arithmetic<X>::value
+  && !std::is_enum<X>::value, int>::type = 0>
+std::uint64_t unpack_hash_value(const X& x) {
+  return std::hash<X>()(x);
+}
+
+// Folds column N of the given rows into the running hashes h. rows == nullptr
+// stands for the contiguous rows [first, first + n), which keeps the loop a
+// plain sweep over the column that the compiler can vectorize.
+template <std::size_t N, typename T>
+void hash_column(const std::vector<unpack<T>>& v, const std::size_t* rows, std::size_t first,
+    std::size_t n, std::uint64_t* h) {
+  auto p = v.template data<N>();
+  if (rows) {
+    for (std::size_t i = 0; i < n; i++) {
+      h[i] = unpack_hash_mix(h[i] ^ unpack_hash_value(p[rows[i]]));
+    }
+  } else {
+    p += first;
+    for (std::size_t i = 0; i < n; i++) {
+      h[i] = unpack_hash_mix(h[i] ^ unpack_hash_value(p[i]));
+    }
+  }
+}
+
+// Hashes key columns Keys of the given rows one column at a time.
+template <std::size_t ... Keys, typename T>
+void hash_columns(const std::vector<unpack<T>>& v, const std::size_t* rows, std::size_t first,
+    std::size_t n, std::uint64_t* h) {
+  std::fill(h, h + n, unpack_hash_seed);
+  using dummy = int[];
+  (void)dummy{1, (hash_column<Keys>(v, rows, first, n, h), int{})...};
+}
+
+#endif
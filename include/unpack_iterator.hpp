@@ -1,8 +1,27 @@
 #ifndef UNPACK_ITERATOR
 #define UNPACK_ITERATOR
 
+#include <iterator>
 #include "unpack_details.hpp"
 
+// Stands in for a pointer to the tuple of references an unpack iterator
+// dereferences to, which is a temporary rather than an object in memory.
+template <typename Reference>
+class unpack_pointer_proxy {
+  private:
+    Reference _ref;
+
+  public:
+    unpack_pointer_proxy(Reference&& ref)
+      : _ref(std::forward<Reference>(ref))
+    {
+    }
+
+    Reference* operator->() {
+      return &_ref;
+    }
+};
+
 template <typename tuple_iters_type>
 class unpack_iterator {
   private: 
@@ -12,10 +31,12 @@ class unpack_iterator {
 
   public:
     using difference_type = std::ptrdiff_t;
-    using value_type = tuple_refs_type; 
-    using pointer = tuple_refs_type; // TODO
+    using value_type = underlying_data_type; 
+    using pointer = unpack_pointer_proxy<tuple_refs_type>;
     using reference = tuple_refs_type;
-    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+
+    unpack_iterator() {}
 
     unpack_iterator(tuple_iters_type&& d) 
       : _data(std::forward<tuple_iters_type>(d))
@@ -44,19 +65,23 @@ class unpack_iterator {
       return it;  
     }
 
-    tuple_refs_type operator*() {
+    tuple_refs_type operator*() const {
       return make_tuple_refs(_data);
     }
 
-    bool operator==(const unpack_iterator& rhs) {
+    pointer operator->() const {
+      return pointer(operator*());
+    }
+
+    bool operator==(const unpack_iterator& rhs) const {
       return rhs._data == _data;
     }
 
-    bool operator!=(const unpack_iterator& rhs) {
+    bool operator!=(const unpack_iterator& rhs) const {
       return rhs._data != _data;     
     }
 
-    difference_type operator-(const unpack_iterator& rhs) {
+    difference_type operator-(const unpack_iterator& rhs) const {
       return std::get<0>(_data) - std::get<0>(rhs._data);
     }
 
@@ -67,7 +92,7 @@ class unpack_iterator {
       return *this;
     }
 
-    unpack_iterator operator-(difference_type dt) {
+    unpack_iterator operator-(difference_type dt) const {
       unpack_iterator tmp = *this;
       tmp -= dt;
       return tmp;  
@@ -80,37 +105,41 @@ class unpack_iterator {
       return *this;
     }
 
-    unpack_iterator operator+(difference_type dt) {
+    unpack_iterator operator+(difference_type dt) const {
       unpack_iterator tmp = *this;
       tmp += dt;
       return tmp;
     }
 
-    tuple_refs_type operator[](size_t index) {
+    tuple_refs_type operator[](difference_type index) const {
       unpack_iterator tmp = *this;
       tmp += index;
       return *tmp;
     }
 
-    bool operator<(const unpack_iterator& rhs) {
+    bool operator<(const unpack_iterator& rhs) const {
       return std::get<0>(_data) < std::get<0>(rhs._data); 
     }
 
-    bool operator<=(const unpack_iterator& rhs) {
+    bool operator<=(const unpack_iterator& rhs) const {
       return std::get<0>(_data) <= std::get<0>(rhs._data); 
     }
 
-    bool operator>(const unpack_iterator& rhs) {
+    bool operator>(const unpack_iterator& rhs) const {
       return std::get<0>(_data) > std::get<0>(rhs._data); 
     }
 
-    bool operator>=(const unpack_iterator& rhs) {
+    bool operator>=(const unpack_iterator& rhs) const {
       return std::get<0>(_data) >= std::get<0>(rhs._data); 
     }
 
     tuple_iters_type* data() {
       return &_data;
     }
+
+    friend unpack_iterator operator+(difference_type dt, const unpack_iterator& it) {
+      return it + dt;
+    }
 };
 
 template <typename tuple_iters_type>
@@ -122,10 +151,12 @@ class unpack_const_iterator {
 
   public:
     using difference_type = std::ptrdiff_t;
-    using value_type = tuple_const_refs_type;
-    using pointer = tuple_const_refs_type; // TODO
+    using value_type = underlying_data_type;
+    using pointer = unpack_pointer_proxy<tuple_const_refs_type>;
     using reference = tuple_const_refs_type;
-    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+
+  unpack_const_iterator() {}
 
   unpack_const_iterator(tuple_iters_type&& d)
     : _data(std::forward<tuple_iters_type>(d)) 
@@ -154,18 +185,22 @@ class unpack_const_iterator {
     return it;  
   }
 
-  tuple_const_refs_type operator*() {
+  tuple_const_refs_type operator*() const {
     return  make_tuple_refs(_data);
   }
 
-  bool operator==(const unpack_const_iterator& rhs) {
+  pointer operator->() const {
+    return pointer(operator*());
+  }
+
+  bool operator==(const unpack_const_iterator& rhs) const {
     return rhs._data == _data;
   }
 
-  bool operator!=(const unpack_const_iterator& rhs) {
+  bool operator!=(const unpack_const_iterator& rhs) const {
     return rhs._data != _data;     
   }
-  difference_type operator-(const unpack_const_iterator& rhs) {
+  difference_type operator-(const unpack_const_iterator& rhs) const {
     return std::get<0>(_data) - std::get<0>(rhs._data);
   }
 
@@ -176,7 +211,7 @@ class unpack_const_iterator {
     return *this;
   }
 
-  unpack_const_iterator operator-(difference_type dt) {
+  unpack_const_iterator operator-(difference_type dt) const {
     unpack_const_iterator tmp = *this;
     tmp -= dt;
     return tmp;  
@@ -189,37 +224,41 @@ class unpack_const_iterator {
     return *this;
   }
 
-  unpack_const_iterator operator+(difference_type dt) {
+  unpack_const_iterator operator+(difference_type dt) const {
     unpack_const_iterator tmp = *this;
     tmp += dt;
     return tmp;
   }
 
-  tuple_const_refs_type operator[](size_t index) {
+  tuple_const_refs_type operator[](difference_type index) const {
     unpack_const_iterator tmp = *this;
     tmp += index;
     return *tmp;
   }
 
-  bool operator<(const unpack_const_iterator& rhs) {
+  bool operator<(const unpack_const_iterator& rhs) const {
     return std::get<0>(_data) < std::get<0>(rhs._data); 
   }
 
-  bool operator<=(const unpack_const_iterator& rhs) {
+  bool operator<=(const unpack_const_iterator& rhs) const {
     return std::get<0>(_data) <= std::get<0>(rhs._data); 
   }
 
-  bool operator>(const unpack_const_iterator& rhs) {
+  bool operator>(const unpack_const_iterator& rhs) const {
     return std::get<0>(_data) > std::get<0>(rhs._data); 
   }
 
-  bool operator>=(const unpack_const_iterator& rhs) {
+  bool operator>=(const unpack_const_iterator& rhs) const {
     return std::get<0>(_data) >= std::get<0>(rhs._data); 
   }
 
   tuple_iters_type* data() {
     return &_data;
   }
+
+  friend unpack_const_iterator operator+(difference_type dt, const unpack_const_iterator& it) {
+    return it + dt;
+  }
 };
 
 #endif
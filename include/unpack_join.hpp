@@ -0,0 +1,269 @@
+#ifndef UNPACK_JOIN
+#define UNPACK_JOIN
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "unpack_hash.hpp"
+#include "unpack_parallel.hpp"
+#include "unpack_vector.hpp"
+
+// Probe rows hashed and looked up per batch.
+constexpr std::size_t unpack_join_batch_rows = 4096;
+
+// Hash table over the key column of the build side of a join. Entries are
+// grouped by bucket into contiguous arrays of hashes, keys and row ids, so
+// a probe reads one bucket offset and then a short sequential run of
+// hashes, touching the key and the build side only on a hash match.
+template <typename K>
+class unpack_join_table {
+  private:
+    std::size_t _mask;
+    std::vector<std::size_t> _offsets;
+    std::vector<std::uint64_t> _hashes;
+    std::vector<K> _keys;
+    std::vector<std::size_t> _rows;
+
+  public:
+    // Builds the table over the rows rows[0, n) of column p, whose key
+    // hashes are h. rows == nullptr stands for the rows [0, n).
+    unpack_join_table(const K* p, const std::size_t* rows, const std::uint64_t* h,
+        std::size_t n)
+      : _mask(1), _hashes(n), _keys(n), _rows(n)
+    {
+      while (_mask < n) {
+        _mask <<= 1;
+      }
+      _offsets.assign(_mask + 1, 0);
+      _mask--;
+      for (std::size_t i = 0; i < n; i++) {
+        _offsets[(h[i] & _mask) + 1]++;
+      }
+      for (std::size_t b = 0; b < _mask + 1; b++) {
+        _offsets[b + 1] += _offsets[b];
+      }
+      std::vector<std::size_t> next(_offsets.begin(), _offsets.end() - 1);
+      for (std::size_t i = 0; i < n; i++) {
+        std::size_t r = rows ? rows[i] : i;
+        std::size_t e = next[h[i] & _mask]++;
+        _hashes[e] = h[i];
+        _keys[e] = p[r];
+        _rows[e] = r;
+      }
+    }
+
+    // Calls f(row) for every build row whose key equals key.
+    template <typename F>
+    void probe(const K& key, std::uint64_t h, F&& f) const {
+      std::size_t b = h & _mask;
+      for (std::size_t e = _offsets[b]; e < _offsets[b + 1]; e++) {
+        if (_hashes[e] == h && _keys[e] == key) {
+          f(_rows[e]);
+        }
+      }
+    }
+};
+
+template <typename X>
+void gather_column(X* out, const X* in, const std::vector<std::size_t>& rows) {
+  for (std::size_t j = 0; j < rows.size(); j++) {
+    out[j] = in[rows[j]];
+  }
+}
+
+template <typename R, typename T, std::size_t ... Indices, std::size_t ... Outputs>
+void gather_columns(R& result, const std::vector<unpack<T>>& v,
+    const std::vector<std::size_t>& rows, std::index_sequence<Indices ...>,
+    std::index_sequence<Outputs ...>) {
+  using dummy = int[];
+  (void)dummy{1, (gather_column(result.template data<Outputs>(), v.template data<Indices>(),
+        rows), int{})...};
+}
+
+// Copies columns Indices of the given rows of v into a new vector, one
+// column at a time.
+template <std::size_t ... Indices, typename T>
+std::vector<unpack<std::tuple<typename std::tuple_element<Indices, T>::type ...>>>
+gather_rows(const std::vector<unpack<T>>& v, const std::vector<std::size_t>& rows) {
+  using result_type = std::tuple<typename std::tuple_element<Indices, T>::type ...>;
+  std::vector<unpack<result_type>> result(rows.size());
+  gather_columns(result, v, rows, std::index_sequence<Indices ...>{},
+      std::index_sequence_for<typename std::tuple_element<Indices, T>::type ...>{});
+  return result;
+}
+
+// Result of hash_join: the matching row pairs as two row id lists. No
+// other column is read until it is asked for through left or right.
+template <typename T, typename U>
+class unpack_join {
+  private:
+    const std::vector<unpack<T>>& _left;
+    const std::vector<unpack<U>>& _right;
+    std::vector<std::size_t> _left_rows;
+    std::vector<std::size_t> _right_rows;
+
+  public:
+    unpack_join(const std::vector<unpack<T>>& left, const std::vector<unpack<U>>& right,
+        std::vector<std::size_t> left_rows, std::vector<std::size_t> right_rows)
+      : _left(left), _right(right), _left_rows(std::move(left_rows)),
+      _right_rows(std::move(right_rows))
+    {
+    }
+
+    std::size_t size() const {
+      return _left_rows.size();
+    }
+
+    // Row i of the join pairs row left_rows()[i] of left with row
+    // right_rows()[i] of right.
+    const std::vector<std::size_t>& left_rows() const {
+      return _left_rows;
+    }
+
+    const std::vector<std::size_t>& right_rows() const {
+      return _right_rows;
+    }
+
+    // Columns Indices of left, one row per joined row.
+    template <std::size_t ... Indices>
+    auto left() const {
+      return gather_rows<Indices ...>(_left, _left_rows);
+    }
+
+    // Columns Indices of right, one row per joined row.
+    template <std::size_t ... Indices>
+    auto right() const {
+      return gather_rows<Indices ...>(_right, _right_rows);
+    }
+};
+
+// Probes the table with the rows rows[0, n) of column Key of v, whose key
+// hashes are h, appending the probe and build row of every match.
+// rows == nullptr stands for the rows [first, first + n).
+template <std::size_t Key, typename T, typename K>
+void probe_join_table(const unpack_join_table<K>& table, const std::vector<unpack<T>>& v,
+    const std::size_t* rows, std::size_t first, const std::uint64_t* h, std::size_t n,
+    std::vector<std::size_t>& probe_rows, std::vector<std::size_t>& build_rows) {
+  auto p = v.template data<Key>();
+  for (std::size_t i = 0; i < n; i++) {
+    std::size_t r = rows ? rows[i] : first + i;
+    table.probe(p[r], h[i], [&](std::size_t b) {
+      probe_rows.push_back(r);
+      build_rows.push_back(b);
+    });
+  }
+}
+
+// Splits the rows of v into `parts` partitions on the top bits of the hash
+// of column Key. rows[c][p] and hashes[c][p] receive the rows of chunk c
+// that fall in partition p and their hashes; chunks are hashed in parallel.
+template <std::size_t Key, typename T>
+void radix_partition(const std::vector<unpack<T>>& v, std::size_t parts, std::size_t threads,
+    std::vector<std::vector<std::vector<std::size_t>>>& rows,
+    std::vector<std::vector<std::vector<std::uint64_t>>>& hashes) {
+  std::size_t bits = 0;
+  while ((std::size_t(1) << bits) < parts) {
+    bits++;
+  }
+  rows.assign(threads, std::vector<std::vector<std::size_t>>(parts));
+  hashes.assign(threads, std::vector<std::vector<std::uint64_t>>(parts));
+  parallel_run(threads, threads, [&](std::size_t c) {
+    std::vector<std::uint64_t> h(unpack_join_batch_rows);
+    std::size_t last = v.size() * (c + 1) / threads;
+    for (std::size_t first = v.size() * c / threads; first < last;
+        first += unpack_join_batch_rows) {
+      std::size_t n = std::min(unpack_join_batch_rows, last - first);
+      hash_columns<Key>(v, nullptr, first, n, h.data());
+      for (std::size_t i = 0; i < n; i++) {
+        std::size_t p = bits ? h[i] >> (64 - bits) : 0;
+        rows[c][p].push_back(first + i);
+        hashes[c][p].push_back(h[i]);
+      }
+    }
+  });
+}
+
+// Joins build and probe on build column BuildKey == probe column ProbeKey,
+// appending the row ids of every matching pair.
+template <std::size_t BuildKey, std::size_t ProbeKey, typename T, typename U>
+void hash_join_rows(const std::vector<unpack<T>>& build, const std::vector<unpack<U>>& probe,
+    std::size_t threads, std::vector<std::size_t>& build_rows,
+    std::vector<std::size_t>& probe_rows) {
+  using key_type = typename std::tuple_element<BuildKey, T>::type;
+  if (threads <= 1) {
+    std::vector<std::uint64_t> h(build.size());
+    for (std::size_t first = 0; first < build.size(); first += unpack_join_batch_rows) {
+      std::size_t n = std::min(unpack_join_batch_rows, build.size() - first);
+      hash_columns<BuildKey>(build, nullptr, first, n, h.data() + first);
+    }
+    unpack_join_table<key_type> table(build.template data<BuildKey>(), nullptr, h.data(),
+        build.size());
+    h.resize(unpack_join_batch_rows);
+    for (std::size_t first = 0; first < probe.size(); first += unpack_join_batch_rows) {
+      std::size_t n = std::min(unpack_join_batch_rows, probe.size() - first);
+      hash_columns<ProbeKey>(probe, nullptr, first, n, h.data());
+      probe_join_table<ProbeKey>(table, probe, nullptr, first, h.data(), n, probe_rows,
+          build_rows);
+    }
+    return;
+  }
+  // Radix partitioning both sides on the same hash bits leaves partition p
+  // of the probe side matching only partition p of the build side, so each
+  // partition is built and probed by one thread on a table sized to it.
+  std::size_t parts = 1;
+  while (parts < threads) {
+    parts <<= 1;
+  }
+  std::vector<std::vector<std::vector<std::size_t>>> build_part, probe_part;
+  std::vector<std::vector<std::vector<std::uint64_t>>> build_hash, probe_hash;
+  radix_partition<BuildKey>(build, parts, threads, build_part, build_hash);
+  radix_partition<ProbeKey>(probe, parts, threads, probe_part, probe_hash);
+  std::vector<std::vector<std::size_t>> part_build_rows(parts), part_probe_rows(parts);
+  parallel_run(parts, threads, [&](std::size_t p) {
+    std::vector<std::size_t> rows;
+    std::vector<std::uint64_t> h;
+    for (std::size_t c = 0; c < threads; c++) {
+      rows.insert(rows.end(), build_part[c][p].begin(), build_part[c][p].end());
+      h.insert(h.end(), build_hash[c][p].begin(), build_hash[c][p].end());
+    }
+    unpack_join_table<key_type> table(build.template data<BuildKey>(), rows.data(), h.data(),
+        rows.size());
+    for (std::size_t c = 0; c < threads; c++) {
+      probe_join_table<ProbeKey>(table, probe, probe_part[c][p].data(), 0,
+          probe_hash[c][p].data(), probe_part[c][p].size(), part_probe_rows[p],
+          part_build_rows[p]);
+    }
+  });
+  for (std::size_t p = 0; p < parts; p++) {
+    build_rows.insert(build_rows.end(), part_build_rows[p].begin(), part_build_rows[p].end());
+    probe_rows.insert(probe_rows.end(), part_probe_rows[p].begin(), part_probe_rows[p].end());
+  }
+}
+
+// Inner equi-join of left and right on left column LeftKey == right column
+// RightKey, e.g. hash_join<0, 1>(orders, customers). The table is built on
+// the smaller side and probed with the other side's key column only; with
+// threads > 1 both sides are radix partitioned and the partitions joined in
+// parallel. Pairs are grouped by probe row, in no guaranteed order across
+// partitions. left and right must outlive the result.
+template <std::size_t LeftKey, std::size_t RightKey, typename T, typename U>
+unpack_join<T, U> hash_join(const std::vector<unpack<T>>& left,
+    const std::vector<unpack<U>>& right, std::size_t threads = 1) {
+  static_assert(std::is_same<typename std::tuple_element<LeftKey, T>::type,
+      typename std::tuple_element<RightKey, U>::type>::value,
+      "hash_join needs key columns of the same type");
+  std::vector<std::size_t> left_rows, right_rows;
+  if (left.size() <= right.size()) {
+    hash_join_rows<LeftKey, RightKey>(left, right, threads, left_rows, right_rows);
+  } else {
+    hash_join_rows<RightKey, LeftKey>(right, left, threads, right_rows, left_rows);
+  }
+  return unpack_join<T, U>(left, right, std::move(left_rows), std::move(right_rows));
+}
+
+#endif
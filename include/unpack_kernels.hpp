@@ -0,0 +1,45 @@
+#ifndef UNPACK_KERNELS
+#define UNPACK_KERNELS
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+#include "unpack_simd.hpp"
+#include "unpack_vector.hpp"
+
+template <std::size_t N, typename T>
+using column_element_t = typename std::tuple_element<N, T>::type;
+
+// Sets every element of column N to value.
+template <std::size_t N, typename T>
+void column_fill(std::vector<unpack<T>>& v, const column_element_t<N, T>& value,
+    simd_level level = simd_runtime_level()) {
+  UNPACK_COLUMN_DISPATCH(level, fill, v.template data<N>(), v.size(), value)
+}
+
+// Replaces every element x of column N with f(x).
+template <std::size_t N, typename T, typename F>
+void column_transform(std::vector<unpack<T>>& v, F f,
+    simd_level level = simd_runtime_level()) {
+  UNPACK_COLUMN_DISPATCH(level, transform, v.template data<N>(), v.size(), f)
+}
+
+// Folds column N into init with op, in unspecified order.
+template <std::size_t N, typename T, typename R, typename Op>
+R column_reduce(const std::vector<unpack<T>>& v, R init, Op op,
+    simd_level level = simd_runtime_level()) {
+  UNPACK_COLUMN_DISPATCH(level, reduce, v.template data<N>(), v.size(), init, op)
+}
+
+// Folds transform(x, y) for the elements x of column N and y of column M of
+// the same row into init with reduce, in unspecified order.
+template <std::size_t N, std::size_t M, typename T, typename R, typename Reduce,
+         typename Transform>
+R column_transform_reduce(const std::vector<unpack<T>>& v, R init, Reduce reduce,
+    Transform transform, simd_level level = simd_runtime_level()) {
+  UNPACK_COLUMN_DISPATCH(level, transform_reduce, v.template data<N>(),
+      v.template data<M>(), v.size(), init, reduce, transform)
+}
+
+#endif
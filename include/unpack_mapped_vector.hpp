@@ -0,0 +1,569 @@
+#ifndef UNPACK_MAPPED_VECTOR
+#define UNPACK_MAPPED_VECTOR
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "unpack_details.hpp"
+#include "unpack_expression.hpp"
+#include "unpack_iterator.hpp"
+
+// Rows a mapped_vector can hold unless told otherwise. Columns reserve
+// address space for this many rows, which costs no memory until used.
+constexpr std::size_t unpack_mapped_rows = std::size_t(1) << 32;
+
+inline std::size_t unpack_page_size() {
+  static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+inline std::size_t unpack_round_to_pages(std::size_t bytes) {
+  std::size_t page = unpack_page_size();
+  return (bytes + page - 1) / page * page;
+}
+
+// Storage policy of mapped_vector keeping a column in an address range
+// reserved up front for max_rows rows, mapped PROT_NONE. Growing makes
+// further pages of the range accessible, which the kernel backs with
+// memory on first write, so the column never moves: growth costs
+// O(new pages) and pointers into the column stay valid until it is
+// destroyed.
+template <typename X>
+class unpack_reserved_column {
+  static_assert(std::is_trivially_copyable<X>::value,
+      "mapped_vector: columns must be trivially copyable");
+
+  private:
+    X* _data;
+    std::size_t _capacity;
+    std::size_t _committed;
+    std::size_t _reserved;
+    std::size_t _max_rows;
+
+    unsigned char* bytes() const {
+      return reinterpret_cast<unsigned char*>(_data);
+    }
+
+  public:
+    explicit unpack_reserved_column(std::size_t max_rows)
+      : _data(nullptr), _capacity(0), _committed(0), _reserved(0), _max_rows(max_rows)
+    {
+      if (max_rows > std::size_t(-1) / sizeof(X)) {
+        throw std::length_error("unpack_reserved_column: max_rows is too large");
+      }
+      _reserved = unpack_round_to_pages(max_rows * sizeof(X));
+      if (_reserved) {
+        void* p = ::mmap(nullptr, _reserved, PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) {
+          throw std::bad_alloc();
+        }
+        _data = static_cast<X*>(p);
+      }
+    }
+
+    unpack_reserved_column(unpack_reserved_column&& c)
+      : _data(c._data), _capacity(c._capacity), _committed(c._committed),
+        _reserved(c._reserved), _max_rows(c._max_rows)
+    {
+      c._data = nullptr;
+      c._capacity = c._committed = c._reserved = 0;
+    }
+
+    unpack_reserved_column(const unpack_reserved_column&) = delete;
+    unpack_reserved_column& operator=(const unpack_reserved_column&) = delete;
+
+    unpack_reserved_column& operator=(unpack_reserved_column&& c) {
+      swap(c);
+      return *this;
+    }
+
+    ~unpack_reserved_column() {
+      if (_data) {
+        ::munmap(_data, _reserved);
+      }
+    }
+
+    X* data() const {
+      return _data;
+    }
+
+    std::size_t capacity() const {
+      return _capacity;
+    }
+
+    std::size_t max_size() const {
+      return _max_rows;
+    }
+
+    // Makes room for at least `rows` rows. Pages are committed at least
+    // doubling, like vector capacity, which keeps the mprotect calls
+    // logarithmic in the size; they are only backed once written.
+    void reserve(std::size_t rows) {
+      if (rows <= _capacity) {
+        return;
+      }
+      if (rows > _max_rows) {
+        throw std::length_error("unpack_reserved_column: rows exceed the reservation");
+      }
+      std::size_t committed = std::min(
+          unpack_round_to_pages(std::max(rows * sizeof(X), 2 * _committed)), _reserved);
+      if (::mprotect(bytes() + _committed, committed - _committed,
+            PROT_READ | PROT_WRITE) != 0) {
+        throw std::bad_alloc();
+      }
+      _committed = committed;
+      _capacity = std::min(committed / sizeof(X), _max_rows);
+    }
+
+    // Returns the pages past the first `rows` rows to the kernel and
+    // makes them inaccessible again.
+    void shrink(std::size_t rows) {
+      std::size_t committed = unpack_round_to_pages(rows * sizeof(X));
+      if (committed >= _committed) {
+        return;
+      }
+      ::madvise(bytes() + committed, _committed - committed, MADV_DONTNEED);
+      ::mprotect(bytes() + committed, _committed - committed, PROT_NONE);
+      _committed = committed;
+      _capacity = std::min(committed / sizeof(X), _max_rows);
+    }
+
+    void swap(unpack_reserved_column& c) {
+      std::swap(_data, c._data);
+      std::swap(_capacity, c._capacity);
+      std::swap(_committed, c._committed);
+      std::swap(_reserved, c._reserved);
+      std::swap(_max_rows, c._max_rows);
+    }
+};
+
+// Storage policy of mapped_vector keeping a column in its own anonymous
+// mapping, sized to the capacity. Growing remaps it with
+// mremap(MREMAP_MAYMOVE), which moves the pages rather than their bytes,
+// so growing a large column costs O(pages) instead of O(bytes). Unlike
+// unpack_reserved_column the column may move as it grows.
+template <typename X>
+class unpack_remapped_column {
+  static_assert(std::is_trivially_copyable<X>::value,
+      "mapped_vector: columns must be trivially copyable");
+
+  private:
+    X* _data;
+    std::size_t _capacity;
+    std::size_t _mapped;
+    std::size_t _max_rows;
+
+    void remap(std::size_t mapped) {
+      void* p;
+      if (_mapped == 0) {
+        p = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      } else if (mapped == 0) {
+        ::munmap(_data, _mapped);
+        p = nullptr;
+      } else {
+#if defined(__linux__)
+        p = ::mremap(_data, _mapped, mapped, MREMAP_MAYMOVE);
+#else
+        p = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+          std::memcpy(p, _data, std::min(mapped, _mapped));
+          ::munmap(_data, _mapped);
+        }
+#endif
+      }
+      if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      _data = static_cast<X*>(p);
+      _mapped = mapped;
+      _capacity = std::min(mapped / sizeof(X), _max_rows);
+    }
+
+  public:
+    explicit unpack_remapped_column(std::size_t max_rows)
+      : _data(nullptr), _capacity(0), _mapped(0), _max_rows(max_rows)
+    {
+    }
+
+    unpack_remapped_column(unpack_remapped_column&& c)
+      : _data(c._data), _capacity(c._capacity), _mapped(c._mapped), _max_rows(c._max_rows)
+    {
+      c._data = nullptr;
+      c._capacity = c._mapped = 0;
+    }
+
+    unpack_remapped_column(const unpack_remapped_column&) = delete;
+    unpack_remapped_column& operator=(const unpack_remapped_column&) = delete;
+
+    unpack_remapped_column& operator=(unpack_remapped_column&& c) {
+      swap(c);
+      return *this;
+    }
+
+    ~unpack_remapped_column() {
+      if (_data) {
+        ::munmap(_data, _mapped);
+      }
+    }
+
+    X* data() const {
+      return _data;
+    }
+
+    std::size_t capacity() const {
+      return _capacity;
+    }
+
+    std::size_t max_size() const {
+      return _max_rows;
+    }
+
+    // Makes room for at least `rows` rows, at least doubling the mapping.
+    void reserve(std::size_t rows) {
+      if (rows <= _capacity) {
+        return;
+      }
+      if (rows > _max_rows) {
+        throw std::length_error("unpack_remapped_column: rows exceed max_size");
+      }
+      remap(unpack_round_to_pages(std::max(rows * sizeof(X), 2 * _mapped)));
+    }
+
+    // Unmaps the pages past the first `rows` rows.
+    void shrink(std::size_t rows) {
+      std::size_t mapped = unpack_round_to_pages(rows * sizeof(X));
+      if (mapped < _mapped) {
+        remap(mapped);
+      }
+    }
+
+    void swap(unpack_remapped_column& c) {
+      std::swap(_data, c._data);
+      std::swap(_capacity, c._capacity);
+      std::swap(_mapped, c._mapped);
+      std::swap(_max_rows, c._max_rows);
+    }
+};
+
+template <typename T, template <typename> class Storage, typename Indices>
+struct mapped_vector_types_helper;
+
+template <typename T, template <typename> class Storage, std::size_t ... Indices>
+struct mapped_vector_types_helper<T, Storage, std::index_sequence<Indices ...>> {
+  using data_type = std::tuple<Storage<typename std::tuple_element<Indices, T>::type> ...>;
+  using iters_type = std::tuple<typename std::tuple_element<Indices, T>::type* ...>;
+  using const_iters_type = std::tuple<const typename std::tuple_element<Indices, T>::type* ...>;
+
+  static data_type make_columns(std::size_t max_rows) {
+    return data_type(((void)Indices, max_rows) ...);
+  }
+};
+
+template <typename T, template <typename> class Storage>
+struct mapped_vector_types {
+  using Indices = std::make_index_sequence<std::tuple_size<T>::value>;
+  using helper = mapped_vector_types_helper<T, Storage, Indices>;
+  using data_type = typename helper::data_type;
+  using iters_type = typename helper::iters_type;
+  using const_iters_type = typename helper::const_iters_type;
+};
+
+template <typename T, template <typename> class Storage = unpack_reserved_column>
+class mapped_vector;
+
+// A vector<unpack<T>> of trivially copyable columns whose memory comes
+// straight from the kernel, managed by a storage policy per column. With
+// the default unpack_reserved_column, growing never relocates a column, so
+// pointers and spans into columns stay valid as the vector grows, up to
+// max_size() rows. With unpack_remapped_column, columns may move but
+// growing them never copies their bytes. Offers the row and column access
+// of vector<unpack<T>>, with iterators over raw column pointers.
+template <typename T, template <typename> class Storage>
+class mapped_vector<unpack<T>, Storage> {
+  private:
+    using types = mapped_vector_types<T, Storage>;
+    using tuple_refs_type = typename unpack_tuple_refs_type<T>::type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+    typename types::data_type _data;
+    std::size_t _size;
+
+    // Grows the columns geometrically for push_back.
+    void grow_for(std::size_t size) {
+      if (size > capacity()) {
+        reserve(std::max(size, std::min(2 * capacity(), max_size())));
+      }
+    }
+
+    void copy_from(const mapped_vector& v) {
+      reserve(v._size);
+      tuple_for_each([&v](auto& cur_col, auto& source_col) {
+        using X = typename std::remove_pointer<decltype(cur_col.data())>::type;
+        if (v._size) {
+          std::memcpy(cur_col.data(), source_col.data(), v._size * sizeof(X));
+        }
+      }, _data, v._data);
+      _size = v._size;
+    }
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = unpack_iterator<typename types::iters_type>;
+    using const_iterator = unpack_const_iterator<typename types::const_iters_type>;
+
+    explicit mapped_vector(std::size_t max_rows = unpack_mapped_rows)
+      : _data(types::helper::make_columns(max_rows)), _size(0)
+    {
+    }
+
+    mapped_vector(const mapped_vector& v) : mapped_vector(v.max_size()) {
+      copy_from(v);
+    }
+
+    mapped_vector(mapped_vector&& v) : _data(std::move(v._data)), _size(v._size) {
+      v._size = 0;
+    }
+
+    mapped_vector& operator=(const mapped_vector& v) {
+      if (this != &v) {
+        clear();
+        copy_from(v);
+      }
+      return *this;
+    }
+
+    mapped_vector& operator=(mapped_vector&& v) {
+      swap(v);
+      return *this;
+    }
+
+    std::size_t size() const {
+      return _size;
+    }
+
+    // Rows every column has room for; wider columns commit fewer rows per
+    // page.
+    std::size_t capacity() const {
+      std::size_t capacity = max_size();
+      tuple_for_each([&capacity](auto& cur_col) {
+        capacity = std::min(capacity, cur_col.capacity());
+      }, _data);
+      return capacity;
+    }
+
+    std::size_t max_size() const {
+      return std::get<0>(_data).max_size();
+    }
+
+    bool empty() const {
+      return _size == 0;
+    }
+
+    void reserve(std::size_t size) {
+      tuple_for_each([size](auto& cur_col) { cur_col.reserve(size); }, _data);
+    }
+
+    // Releases the memory behind rows past size().
+    void shrink_to_fit() {
+      std::size_t size = _size;
+      tuple_for_each([size](auto& cur_col) { cur_col.shrink(size); }, _data);
+    }
+
+    void clear() {
+      _size = 0;
+    }
+
+    void push_back(const T& elem) {
+      grow_for(_size + 1);
+      std::size_t index = _size;
+      tuple_for_each([index](auto& cur_col, auto& cur_elem) {
+        cur_col.data()[index] = cur_elem;
+      }, _data, elem);
+      _size++;
+    }
+
+    template <typename ... Args>
+    tuple_refs_type emplace_back(Args&& ... args) {
+      grow_for(_size + 1);
+      std::size_t index = _size;
+      tuple_for_each([index](auto& cur_col, auto&& value) {
+        using X = typename std::remove_pointer<decltype(cur_col.data())>::type;
+        ::new (static_cast<void*>(cur_col.data() + index)) X(std::forward<decltype(value)>(value));
+      }, _data, std::forward_as_tuple(std::forward<Args>(args) ...));
+      _size++;
+      return back();
+    }
+
+    void pop_back() {
+      _size--;
+    }
+
+    void resize(std::size_t size) {
+      resize(size, T());
+    }
+
+    void resize(std::size_t size, const T& value) {
+      reserve(size);
+      if (size > _size) {
+        std::size_t first = _size;
+        tuple_for_each([first, size](auto& cur_col, auto& cur_elem) {
+          std::fill(cur_col.data() + first, cur_col.data() + size, cur_elem);
+        }, _data, value);
+      }
+      _size = size;
+    }
+
+    // Only changes the size. New rows hold whatever their memory last held,
+    // which is zero for pages never written before.
+    void resize(std::size_t size, unpack_default_init_t) {
+      reserve(size);
+      _size = size;
+    }
+
+    void swap(mapped_vector& v) {
+      tuple_for_each([](auto& cur_col, auto& target_cur_col) {
+        cur_col.swap(target_cur_col);
+      }, _data, v._data);
+      std::swap(_size, v._size);
+    }
+
+    tuple_refs_type operator[](std::size_t index) {
+      return tuple_r_at_index(columns(), index);
+    }
+
+    tuple_const_refs_type operator[](std::size_t index) const {
+      return tuple_r_at_index(columns(), index);
+    }
+
+    tuple_refs_type at(std::size_t index) {
+      throw_if_out_of_bounds(index, _size);
+      return operator[](index);
+    }
+
+    tuple_const_refs_type at(std::size_t index) const {
+      throw_if_out_of_bounds(index, _size);
+      return operator[](index);
+    }
+
+    tuple_refs_type front() {
+      return operator[](0);
+    }
+
+    tuple_const_refs_type front() const {
+      return operator[](0);
+    }
+
+    tuple_refs_type back() {
+      return operator[](_size - 1);
+    }
+
+    tuple_const_refs_type back() const {
+      return operator[](_size - 1);
+    }
+
+    template <std::size_t N>
+    auto data() {
+      return std::get<N>(_data).data();
+    }
+
+    template <std::size_t N>
+    auto data() const {
+      return static_cast<const typename std::tuple_element<N, T>::type*>(
+          std::get<N>(_data).data());
+    }
+
+    // Column N as an operand of lazy column expressions, see vector::col.
+    template <std::size_t N>
+    auto col() {
+      return unpack_column<typename std::tuple_element<N, T>::type>(data<N>(), _size);
+    }
+
+    template <std::size_t N>
+    auto col() const {
+      return unpack_column<const typename std::tuple_element<N, T>::type>(data<N>(), _size);
+    }
+
+    // The column pointers, as the tuple the iterators are made of.
+    typename types::iters_type columns() {
+      return make_tuple_vec_iter(_data, [](auto& cur_col) { return cur_col.data(); });
+    }
+
+    typename types::const_iters_type columns() const {
+      return make_tuple_vec_const_iter(_data, [](auto& cur_col) { return cur_col.data(); });
+    }
+
+    iterator begin() {
+      return iterator(columns());
+    }
+
+    iterator end() {
+      return begin() + _size;
+    }
+
+    const_iterator begin() const {
+      return const_iterator(columns());
+    }
+
+    const_iterator end() const {
+      return begin() + _size;
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+    template <std::size_t N>
+    auto begin() {
+      return data<N>();
+    }
+
+    template <std::size_t N>
+    auto end() {
+      return data<N>() + _size;
+    }
+
+    template <std::size_t N>
+    auto begin() const {
+      return data<N>();
+    }
+
+    template <std::size_t N>
+    auto end() const {
+      return data<N>() + _size;
+    }
+
+    friend void swap(mapped_vector& lhs, mapped_vector& rhs) {
+      lhs.swap(rhs);
+    }
+};
+
+template <typename T, template <typename> class Storage>
+bool operator==(const mapped_vector<unpack<T>, Storage>& lhs,
+    const mapped_vector<unpack<T>, Storage>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, template <typename> class Storage>
+bool operator!=(const mapped_vector<unpack<T>, Storage>& lhs,
+    const mapped_vector<unpack<T>, Storage>& rhs) {
+  return !(lhs == rhs);
+}
+
+#endif
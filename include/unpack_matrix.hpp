@@ -0,0 +1,164 @@
+#ifndef UNPACK_MATRIX
+#define UNPACK_MATRIX
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "unpack_vector.hpp"
+
+// Rows per block of the matrix kernels: a block of every column of a
+// 16-column double matrix fits in L1.
+constexpr std::size_t unpack_matrix_block_rows = 128;
+
+// Whether every element of the tuple T has the same type, and that type.
+template <typename T>
+struct unpack_homogeneous : std::false_type {};
+
+template <typename X, typename ... Xs>
+struct unpack_homogeneous<std::tuple<X, Xs ...>>
+  : std::is_same<std::tuple<X, Xs ...>, std::tuple<Xs ..., X>> {
+  using type = X;
+};
+
+// The columns of a vector<unpack<T>> whose columns all have the same type,
+// seen as a matrix with one row per row of the vector and one column per
+// column. Element (row, col) is column(col)[row]: every column is
+// contiguous, but each is its own allocation, so the view keeps a pointer
+// per column rather than a stride. The view does not own the columns and
+// is invalidated by whatever invalidates the vector's iterators.
+template <typename X, std::size_t N>
+class unpack_matrix_view {
+  private:
+    std::array<X*, N> _columns;
+    std::size_t _rows;
+
+  public:
+    using value_type = typename std::remove_const<X>::type;
+
+    unpack_matrix_view(const std::array<X*, N>& columns, std::size_t rows)
+      : _columns(columns), _rows(rows)
+    {
+    }
+
+    std::size_t rows() const {
+      return _rows;
+    }
+
+    static constexpr std::size_t cols() {
+      return N;
+    }
+
+    X& operator()(std::size_t row, std::size_t col) const {
+      return _columns[col][row];
+    }
+
+    X* column(std::size_t col) const {
+      return _columns[col];
+    }
+
+    // Rows [first, first + count) as a view.
+    unpack_matrix_view block(std::size_t first, std::size_t count) const {
+      std::array<X*, N> columns;
+      for (std::size_t c = 0; c < N; c++) {
+        columns[c] = _columns[c] + first;
+      }
+      return unpack_matrix_view(columns, count);
+    }
+};
+
+template <typename T, typename V, std::size_t ... Indices>
+auto as_matrix_helper(V& v, std::index_sequence<Indices ...>) {
+  using X = typename std::remove_pointer<decltype(v.template data<0>())>::type;
+  return unpack_matrix_view<X, sizeof...(Indices)>(
+      std::array<X*, sizeof...(Indices)>{ { v.template data<Indices>() ... } }, v.size());
+}
+
+template <typename T>
+unpack_matrix_view<typename unpack_homogeneous<T>::type, std::tuple_size<T>::value>
+as_matrix(std::vector<unpack<T>>& v) {
+  static_assert(unpack_homogeneous<T>::value, "as_matrix: columns must have the same type");
+  return as_matrix_helper<T>(v, std::make_index_sequence<std::tuple_size<T>::value>());
+}
+
+template <typename T>
+unpack_matrix_view<const typename unpack_homogeneous<T>::type, std::tuple_size<T>::value>
+as_matrix(const std::vector<unpack<T>>& v) {
+  static_assert(unpack_homogeneous<T>::value, "as_matrix: columns must have the same type");
+  return as_matrix_helper<T>(v, std::make_index_sequence<std::tuple_size<T>::value>());
+}
+
+// The kernels below walk the matrix a block of rows at a time and, within
+// a block, a column at a time, so each inner loop runs down contiguous
+// column storage and vectorizes, while the block stays in cache across
+// columns.
+
+// Sets out[row] to the Euclidean norm of each row of a.
+template <typename Matrix, typename R>
+void matrix_row_norms(const Matrix& a, R* out) {
+  for (std::size_t first = 0; first < a.rows(); first += unpack_matrix_block_rows) {
+    std::size_t n = std::min(unpack_matrix_block_rows, a.rows() - first);
+    R* o = out + first;
+    std::fill(o, o + n, R());
+    for (std::size_t c = 0; c < Matrix::cols(); c++) {
+      const auto* x = a.column(c) + first;
+      for (std::size_t i = 0; i < n; i++) {
+        o[i] += static_cast<R>(x[i]) * static_cast<R>(x[i]);
+      }
+    }
+    for (std::size_t i = 0; i < n; i++) {
+      o[i] = std::sqrt(o[i]);
+    }
+  }
+}
+
+// Copies a into out in row-major order: element (row, col) goes to
+// out[row * a.cols() + col].
+template <typename Matrix, typename X>
+void matrix_transpose(const Matrix& a, X* out) {
+  constexpr std::size_t cols = Matrix::cols();
+  for (std::size_t first = 0; first < a.rows(); first += unpack_matrix_block_rows) {
+    std::size_t n = std::min(unpack_matrix_block_rows, a.rows() - first);
+    X* o = out + first * cols;
+    for (std::size_t c = 0; c < cols; c++) {
+      const auto* x = a.column(c) + first;
+      for (std::size_t i = 0; i < n; i++) {
+        o[i * cols + c] = x[i];
+      }
+    }
+  }
+}
+
+// Sets c to a times b, where b is an a.cols() by c.cols() matrix in
+// row-major order. Throws std::invalid_argument if a and c have different
+// numbers of rows.
+template <typename MatrixA, typename X, typename MatrixC>
+void matrix_multiply(const MatrixA& a, const X* b, const MatrixC& c) {
+  if (a.rows() != c.rows()) {
+    throw std::invalid_argument("matrix_multiply: a and c must have the same rows");
+  }
+  constexpr std::size_t inner = MatrixA::cols();
+  constexpr std::size_t cols = MatrixC::cols();
+  for (std::size_t first = 0; first < a.rows(); first += unpack_matrix_block_rows) {
+    std::size_t n = std::min(unpack_matrix_block_rows, a.rows() - first);
+    for (std::size_t k = 0; k < cols; k++) {
+      auto* o = c.column(k) + first;
+      std::fill(o, o + n, typename MatrixC::value_type());
+      for (std::size_t j = 0; j < inner; j++) {
+        const auto* x = a.column(j) + first;
+        X factor = b[j * cols + k];
+        for (std::size_t i = 0; i < n; i++) {
+          o[i] += x[i] * factor;
+        }
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef UNPACK_PARALLEL
+#define UNPACK_PARALLEL
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "unpack_vector.hpp"
+
+constexpr std::size_t unpack_cache_line_size = 64;
+
+// Columns smaller than this are grouped with their neighbours rather than
+// scheduled as tasks of their own.
+constexpr std::size_t unpack_column_task_bytes = 64 * 1024;
+
+inline std::size_t unpack_default_threads() {
+  std::size_t threads = std::thread::hardware_concurrency();
+  return threads ? threads : 1;
+}
+
+// Runs task(0) ... task(count - 1) on up to `threads` threads, the calling
+// thread included. Tasks are handed out in order; the first exception thrown
+// by a task is rethrown once every thread has joined.
+template <typename F>
+void parallel_run(std::size_t count, std::size_t threads, F&& task) {
+  threads = std::min(threads ? threads : unpack_default_threads(), count);
+  if (threads <= 1) {
+    for (std::size_t i = 0; i < count; i++) {
+      task(i);
+    }
+    return;
+  }
+  std::atomic<std::size_t> next(0);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&]() {
+    for (std::size_t i = next++; i < count; i = next++) {
+      try {
+        task(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next = count;
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  for (std::size_t t = 1; t < threads; t++) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+struct column_layout {
+  std::uintptr_t base;
+  std::size_t element_size;
+};
+
+template <typename T, std::size_t ... Indices>
+std::vector<column_layout> column_layouts(const std::vector<unpack<T>>& v,
+    std::index_sequence<Indices ...>) {
+  return { column_layout{ reinterpret_cast<std::uintptr_t>(v.template data<Indices>()),
+    sizeof(typename std::tuple_element<Indices, T>::type) } ... };
+}
+
+template <typename T>
+std::vector<column_layout> column_layouts(const std::vector<unpack<T>>& v) {
+  return column_layouts(v, std::make_index_sequence<std::tuple_size<T>::value>{});
+}
+
+// Row ranges processed in two phases: every chunk first, then every seam.
+// A seam holds the rows around a chunk boundary that share a cache line in
+// some column, so no line is ever written by two threads at the same time.
+struct row_partition {
+  std::vector<std::pair<std::size_t, std::size_t>> chunks;
+  std::vector<std::pair<std::size_t, std::size_t>> seams;
+};
+
+// Smallest row count that spans whole cache lines in every column.
+inline std::size_t cache_line_granule(const std::vector<column_layout>& layouts) {
+  auto gcd = [](std::size_t a, std::size_t b) {
+    while (b) {
+      std::size_t r = a % b;
+      a = b;
+      b = r;
+    }
+    return a;
+  };
+  std::size_t granule = 1;
+  for (auto& c : layouts) {
+    std::size_t rows = unpack_cache_line_size / gcd(unpack_cache_line_size, c.element_size);
+    granule = granule / gcd(granule, rows) * rows;
+  }
+  return granule;
+}
+
+// Rows sharing a cache line with the row boundary at `row`, empty when the
+// boundary falls on a line boundary in every column.
+inline std::pair<std::size_t, std::size_t> cache_line_seam(
+    const std::vector<column_layout>& layouts, std::size_t row, std::size_t size) {
+  std::size_t lo = row;
+  std::size_t hi = row;
+  for (auto& c : layouts) {
+    std::uintptr_t address = c.base + row * c.element_size;
+    if (address % unpack_cache_line_size == 0) {
+      continue;
+    }
+    std::uintptr_t line = address - address % unpack_cache_line_size;
+    std::size_t first = line > c.base ? (line - c.base) / c.element_size : 0;
+    std::size_t last = (line + unpack_cache_line_size - c.base + c.element_size - 1)
+      / c.element_size;
+    lo = std::min(lo, first);
+    hi = std::max(hi, std::min(last, size));
+  }
+  return { lo, hi };
+}
+
+inline row_partition cache_aligned_partition(const std::vector<column_layout>& layouts,
+    std::size_t size, std::size_t parts) {
+  std::size_t granule = cache_line_granule(layouts);
+  std::size_t min_rows = (4 * unpack_cache_line_size + granule - 1) / granule * granule;
+  parts = std::max<std::size_t>(1, std::min(parts, size / min_rows));
+  row_partition partition;
+  std::size_t first = 0;
+  for (std::size_t k = 1; k < parts; k++) {
+    std::size_t boundary = size / parts * k / granule * granule;
+    auto seam = cache_line_seam(layouts, boundary, size);
+    partition.chunks.emplace_back(first, seam.first);
+    if (seam.first != seam.second) {
+      partition.seams.push_back(seam);
+    }
+    first = seam.second;
+  }
+  partition.chunks.emplace_back(first, size);
+  return partition;
+}
+
+template <typename T>
+row_partition cache_aligned_partition(const std::vector<unpack<T>>& v, std::size_t parts) {
+  return cache_aligned_partition(column_layouts(v), v.size(), parts);
+}
+
+// Calls f(first, last) on row ranges of v from several threads. Chunk
+// boundaries are placed so that no cache line of any column is written by
+// two threads concurrently. f is shared between threads.
+template <typename T, typename F>
+void parallel_for_each_row_range(std::vector<unpack<T>>& v, F&& f, std::size_t threads = 0) {
+  threads = threads ? threads : unpack_default_threads();
+  row_partition partition = cache_aligned_partition(v, threads);
+  auto run = [&v, &f, threads](const std::vector<std::pair<std::size_t, std::size_t>>& ranges) {
+    parallel_run(ranges.size(), threads, [&v, &f, &ranges](std::size_t i) {
+      f(v.begin() + ranges[i].first, v.begin() + ranges[i].second);
+    });
+  };
+  run(partition.chunks);
+  run(partition.seams);
+}
+
+// Calls f on every row of v from several threads, see
+// parallel_for_each_row_range.
+template <typename T, typename F>
+void parallel_for_each(std::vector<unpack<T>>& v, F&& f, std::size_t threads = 0) {
+  parallel_for_each_row_range(v, [&f](auto first, auto last) {
+    for (auto it = first; it != last; ++it) {
+      f(*it);
+    }
+  }, threads);
+}
+
+// Splits columns with the given byte counts into at most `parts` groups of
+// adjacent columns, as [first, last) column index ranges. A group is closed
+// once it holds its share of the total bytes, so large columns get a group
+// of their own and small ones are merged.
+inline std::vector<std::pair<std::size_t, std::size_t>> column_groups(
+    const std::vector<std::size_t>& bytes, std::size_t parts) {
+  std::size_t total = 0;
+  for (auto b : bytes) {
+    total += b;
+  }
+  parts = std::max<std::size_t>(parts, 1);
+  std::size_t target = std::max((total + parts - 1) / parts, unpack_column_task_bytes);
+  std::vector<std::pair<std::size_t, std::size_t>> groups;
+  std::size_t first = 0;
+  std::size_t filled = 0;
+  for (std::size_t i = 0; i < bytes.size(); i++) {
+    filled += bytes[i];
+    if (filled >= target && groups.size() + 1 < parts) {
+      groups.emplace_back(first, i + 1);
+      first = i + 1;
+      filled = 0;
+    }
+  }
+  if (first < bytes.size()) {
+    groups.emplace_back(first, bytes.size());
+  }
+  return groups;
+}
+
+template <typename T>
+std::vector<std::pair<std::size_t, std::size_t>> column_groups(
+    const std::vector<unpack<T>>& v, std::size_t parts) {
+  std::vector<std::size_t> bytes;
+  for (auto& c : column_layouts(v)) {
+    bytes.push_back(c.element_size * v.size());
+  }
+  return column_groups(bytes, parts);
+}
+
+template <typename T, typename F, std::size_t ... Indices>
+void visit_column(std::vector<unpack<T>>& v, std::size_t index, F&& f,
+    std::index_sequence<Indices ...>) {
+  using dummy = int[];
+  (void)dummy{1, (index == Indices
+      ? (void)f(v.template begin<Indices>(), v.template end<Indices>()) : void(), int{})...};
+}
+
+// Calls f(first, last) once per column of v, where first and last are
+// iterators of that column, from several threads. Each column, or group of
+// small adjacent columns, is one task, so a thread only ever streams through
+// whole arrays. f is shared between threads and must accept every column
+// type.
+template <typename T, typename F>
+void parallel_for_each_column_range(std::vector<unpack<T>>& v, F&& f,
+    std::size_t threads = 0) {
+  threads = threads ? threads : unpack_default_threads();
+  auto groups = column_groups(v, threads);
+  parallel_run(groups.size(), threads, [&v, &f, &groups](std::size_t i) {
+    for (auto c = groups[i].first; c < groups[i].second; c++) {
+      visit_column(v, c, f, std::make_index_sequence<std::tuple_size<T>::value>{});
+    }
+  });
+}
+
+// Calls f on every field of every row of v from several threads, see
+// parallel_for_each_column_range. Only suitable when the work on a field
+// does not depend on the other fields of its row.
+template <typename T, typename F>
+void parallel_for_each_column(std::vector<unpack<T>>& v, F&& f, std::size_t threads = 0) {
+  parallel_for_each_column_range(v, [&f](auto first, auto last) {
+    for (auto it = first; it != last; ++it) {
+      f(*it);
+    }
+  }, threads);
+}
+
+// Evaluates e into dst like dst = e, with rows split across threads. Chunk
+// boundaries follow the cache lines of dst, as in
+// parallel_for_each_row_range.
+template <typename T, typename E>
+void parallel_assign(unpack_column<T> dst, const unpack_expression<E>& e,
+    std::size_t threads = 0) {
+  if (!e.self().has_size(dst.size())) {
+    throw std::length_error("parallel_assign: expression size does not match column size");
+  }
+  threads = threads ? threads : unpack_default_threads();
+  std::vector<column_layout> layouts = {
+    column_layout{ reinterpret_cast<std::uintptr_t>(dst.data()), sizeof(T) }
+  };
+  row_partition partition = cache_aligned_partition(layouts, dst.size(), threads);
+  auto run = [&dst, &e, threads](const std::vector<std::pair<std::size_t, std::size_t>>& ranges) {
+    parallel_run(ranges.size(), threads, [&dst, &e, &ranges](std::size_t i) {
+      dst.assign(ranges[i].first, ranges[i].second, e.self());
+    });
+  };
+  run(partition.chunks);
+  run(partition.seams);
+}
+
+#endif
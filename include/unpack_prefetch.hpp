@@ -0,0 +1,65 @@
+#ifndef UNPACK_PREFETCH
+#define UNPACK_PREFETCH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "unpack_parallel.hpp"
+#include "unpack_simd.hpp"
+#include "unpack_vector.hpp"
+
+// Bytes, summed over every column, that automatic prefetching keeps in
+// flight ahead of the current row. Half of a typical 32 KiB L1 data cache,
+// so prefetched lines are not evicted before they are used.
+constexpr std::size_t unpack_prefetch_bytes = 16 * 1024;
+
+// Rows to prefetch ahead when iterating over every column of v.
+template <typename T>
+std::size_t unpack_prefetch_distance(const std::vector<unpack<T>>& v) {
+  std::size_t row_bytes = 0;
+  for (const auto& layout : column_layouts(v)) {
+    row_bytes += layout.element_size;
+  }
+  return std::max<std::size_t>(unpack_prefetch_bytes / std::max<std::size_t>(row_bytes, 1), 1);
+}
+
+// Calls f on every row of v in order, prefetching every column `distance`
+// rows ahead, or unpack_prefetch_distance(v) rows when distance is 0. Rows
+// are walked in blocks that fill one cache line of the narrowest column,
+// and each block issues one prefetch per cache line per column for the
+// block `distance` rows ahead. This keeps rows streaming from memory when
+// there are more columns than the hardware prefetcher tracks streams.
+template <typename T, typename F>
+void for_each_prefetched(std::vector<unpack<T>>& v, F&& f, std::size_t distance = 0) {
+  distance = distance ? distance : unpack_prefetch_distance(v);
+  std::vector<column_layout> layouts = column_layouts(v);
+  std::size_t narrowest = unpack_cache_line_size;
+  for (const auto& layout : layouts) {
+    narrowest = std::min(narrowest, layout.element_size);
+  }
+  std::size_t block = unpack_cache_line_size / std::max<std::size_t>(narrowest, 1);
+  std::size_t size = v.size();
+  auto it = v.begin();
+  for (std::size_t first = 0; first < size; first += block) {
+    std::size_t ahead = first + distance;
+    if (ahead < size) {
+      std::size_t ahead_last = std::min(ahead + block, size);
+      for (const auto& layout : layouts) {
+        std::uintptr_t line = (layout.base + ahead * layout.element_size)
+          & ~(static_cast<std::uintptr_t>(unpack_cache_line_size) - 1);
+        std::uintptr_t end = layout.base + ahead_last * layout.element_size;
+        for (; line < end; line += unpack_cache_line_size) {
+          unpack_prefetch(reinterpret_cast<const void*>(line));
+        }
+      }
+    }
+    std::size_t last = std::min(first + block, size);
+    for (std::size_t i = first; i < last; i++) {
+      f(it[i]);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef UNPACK_QUERY
+#define UNPACK_QUERY
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "unpack_simd.hpp"
+#include "unpack_vector.hpp"
+
+// Rows handled per batch. One batch of an 8 byte column fills half of a
+// typical 64 KiB L1 data cache, leaving room for the selection vector.
+constexpr std::size_t unpack_query_batch_rows = 4096;
+
+// Keeps the rows of a batch whose column N satisfies f.
+template <std::size_t N, typename F>
+struct column_predicate {
+  F f;
+
+  // Narrows sel, the offsets of the `selected` rows of the batch starting
+  // at row `first` that passed so far, and returns how many remain. Only
+  // column N is read.
+  template <typename V>
+  std::size_t refine(const V& v, std::size_t first, std::size_t rows, std::uint32_t* sel,
+      std::size_t selected) const {
+    auto p = v.template data<N>() + first;
+    std::size_t kept = 0;
+    if (selected == rows) {
+      for (std::size_t i = 0; i < rows; i++) {
+        sel[kept] = static_cast<std::uint32_t>(i);
+        kept += f(p[i]) ? 1 : 0;
+      }
+    } else {
+      for (std::size_t j = 0; j < selected; j++) {
+        std::uint32_t i = sel[j];
+        sel[kept] = i;
+        kept += f(p[i]) ? 1 : 0;
+      }
+    }
+    return kept;
+  }
+
+  // Whether the batch starting at row `first` can be skipped unread.
+  template <typename V>
+  bool skips(const V&, std::size_t) const {
+    return false;
+  }
+};
+
+template <typename T>
+using unpack_sum_t = typename std::conditional<std::is_integral<T>::value,
+      typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type,
+      T>::type;
+
+// A scan over a vector<unpack<T>>, narrowed by per-column predicates. The
+// query references v, which must outlive it. Every operation runs the
+// scan again in batches of unpack_query_batch_rows rows: the predicates
+// build a selection vector for the batch one column at a time, then only
+// the columns the operation needs are read, through that vector.
+template <typename T, typename ... Predicates>
+class unpack_query {
+  private:
+    const std::vector<unpack<T>>& _v;
+    std::tuple<Predicates ...> _predicates;
+
+    template <std::size_t ... Indices>
+    std::size_t filter(std::size_t first, std::size_t rows, std::uint32_t* sel,
+        std::index_sequence<Indices ...>) const {
+      bool skip = false;
+      using dummy = int[];
+      (void)dummy{1, (skip = skip || std::get<Indices>(_predicates).skips(_v, first), int{})...};
+      if (skip) {
+        return 0;
+      }
+      std::size_t selected = rows;
+      (void)dummy{1, (selected = std::get<Indices>(_predicates)
+          .refine(_v, first, rows, sel, selected), int{})...};
+      if (selected == rows) {
+        for (std::size_t i = 0; i < rows; i++) {
+          sel[i] = static_cast<std::uint32_t>(i);
+        }
+      }
+      return selected;
+    }
+
+    template <typename X, typename R, typename Op>
+    static R reduce_dense(const X* p, std::size_t n, R init, Op& op) {
+      UNPACK_COLUMN_DISPATCH(simd_runtime_level(), reduce, p, n, init, op)
+    }
+
+  public:
+    unpack_query(const std::vector<unpack<T>>& v, std::tuple<Predicates ...> predicates)
+      : _v(v), _predicates(std::move(predicates))
+    {
+    }
+
+    // Adds the condition f(column N) to the query.
+    template <std::size_t N, typename F>
+    unpack_query<T, Predicates ..., column_predicate<N, F>> where(F f) const {
+      return unpack_query<T, Predicates ..., column_predicate<N, F>>(_v,
+          std::tuple_cat(_predicates, std::make_tuple(column_predicate<N, F>{ f })));
+    }
+
+    // Adds a predicate object providing refine and skips, like
+    // column_predicate, e.g. unpack_zone_map::between.
+    template <typename P>
+    unpack_query<T, Predicates ..., P> where(P predicate) const {
+      return unpack_query<T, Predicates ..., P>(_v,
+          std::tuple_cat(_predicates, std::make_tuple(std::move(predicate))));
+    }
+
+    // Calls f(first, sel, selected, rows) per batch of rows [first,
+    // first + rows), where sel holds the offsets from first of the
+    // `selected` rows that satisfy every predicate. Batches without
+    // selected rows, including those a predicate skips, are not passed.
+    template <typename F>
+    void for_each_batch(F&& f) const {
+      std::vector<std::uint32_t> sel(unpack_query_batch_rows);
+      for (std::size_t first = 0; first < _v.size(); first += unpack_query_batch_rows) {
+        std::size_t rows = std::min(unpack_query_batch_rows, _v.size() - first);
+        std::size_t selected = filter(first, rows, sel.data(),
+            std::index_sequence_for<Predicates ...>{});
+        if (selected) {
+          f(first, static_cast<const std::uint32_t*>(sel.data()), selected, rows);
+        }
+      }
+    }
+
+    // Folds column N of the selected rows into init with op, which must be
+    // associative and commutative. Batches where every row is selected are
+    // reduced with the vectorized column kernel.
+    template <std::size_t N, typename R, typename Op>
+    R reduce(R init, Op op, std::size_t* count = nullptr) const {
+      std::size_t total = 0;
+      for_each_batch([&](std::size_t first, const std::uint32_t* sel, std::size_t selected,
+            std::size_t rows) {
+        auto p = _v.template data<N>() + first;
+        if (selected == rows) {
+          init = reduce_dense(p, rows, init, op);
+        } else {
+          for (std::size_t j = 0; j < selected; j++) {
+            init = op(init, p[sel[j]]);
+          }
+        }
+        total += selected;
+      });
+      if (count) {
+        *count = total;
+      }
+      return init;
+    }
+
+    std::size_t count() const {
+      std::size_t total = 0;
+      for_each_batch([&total](std::size_t, const std::uint32_t*, std::size_t selected,
+            std::size_t) {
+        total += selected;
+      });
+      return total;
+    }
+
+    template <std::size_t N>
+    auto sum() const {
+      using R = unpack_sum_t<typename std::tuple_element<N, T>::type>;
+      return reduce<N>(R(), [](R a, R b) { return a + b; });
+    }
+
+    template <std::size_t N>
+    auto min() const {
+      using X = typename std::tuple_element<N, T>::type;
+      std::size_t selected = 0;
+      X result = reduce<N>(std::numeric_limits<X>::max(),
+          [](X a, X b) { return b < a ? b : a; }, &selected);
+      if (selected == 0) {
+        throw std::domain_error("unpack_query::min: no rows selected");
+      }
+      return result;
+    }
+
+    template <std::size_t N>
+    auto max() const {
+      using X = typename std::tuple_element<N, T>::type;
+      std::size_t selected = 0;
+      X result = reduce<N>(std::numeric_limits<X>::lowest(),
+          [](X a, X b) { return a < b ? b : a; }, &selected);
+      if (selected == 0) {
+        throw std::domain_error("unpack_query::max: no rows selected");
+      }
+      return result;
+    }
+
+    // NaN when no rows are selected.
+    template <std::size_t N>
+    double mean() const {
+      using R = unpack_sum_t<typename std::tuple_element<N, T>::type>;
+      std::size_t selected = 0;
+      R total = reduce<N>(R(), [](R a, R b) { return a + b; }, &selected);
+      return static_cast<double>(total) / selected;
+    }
+
+    // Indices of the selected rows, in increasing order.
+    std::vector<std::size_t> selection() const {
+      std::vector<std::size_t> rows;
+      for_each_batch([&rows](std::size_t first, const std::uint32_t* sel, std::size_t selected,
+            std::size_t) {
+        for (std::size_t j = 0; j < selected; j++) {
+          rows.push_back(first + sel[j]);
+        }
+      });
+      return rows;
+    }
+
+    // Copies columns Indices of the selected rows into a new vector, one
+    // column at a time. Other columns are never read.
+    template <std::size_t ... Indices>
+    std::vector<unpack<std::tuple<typename std::tuple_element<Indices, T>::type ...>>>
+    project() const {
+      using result_type = std::tuple<typename std::tuple_element<Indices, T>::type ...>;
+      std::vector<std::size_t> rows = selection();
+      std::vector<unpack<result_type>> result(rows.size());
+      project_columns(result, rows, std::index_sequence<Indices ...>{},
+          std::index_sequence_for<typename std::tuple_element<Indices, T>::type ...>{});
+      return result;
+    }
+
+  private:
+    template <typename R, std::size_t ... Indices, std::size_t ... Outputs>
+    void project_columns(R& result, const std::vector<std::size_t>& rows,
+        std::index_sequence<Indices ...>, std::index_sequence<Outputs ...>) const {
+      using dummy = int[];
+      (void)dummy{1, (gather(result.template data<Outputs>(), _v.template data<Indices>(), rows),
+          int{})...};
+    }
+
+    template <typename X>
+    static void gather(X* out, const X* in, const std::vector<std::size_t>& rows) {
+      for (std::size_t j = 0; j < rows.size(); j++) {
+        out[j] = in[rows[j]];
+      }
+    }
+};
+
+// Starts a query over every row of v.
+template <typename T>
+unpack_query<T> query(const std::vector<unpack<T>>& v) {
+  return unpack_query<T>(v, std::tuple<>());
+}
+
+#endif
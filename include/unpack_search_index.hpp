@@ -0,0 +1,146 @@
+#ifndef UNPACK_SEARCH_INDEX
+#define UNPACK_SEARCH_INDEX
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "unpack_simd.hpp"
+#include "unpack_vector.hpp"
+
+// Searches run in lockstep by the batched lookups. Enough to keep a few
+// cache misses in flight per search without spilling the search state.
+constexpr std::size_t unpack_search_batch = 16;
+
+// Read-only search index over a sorted column N of a vector<unpack<T>>.
+// The keys are copied in Eytzinger order, the breadth-first order of the
+// implicit binary search tree, so the first levels of every search share a
+// few hot cache lines and the node 4 levels down is prefetched while the
+// current one is compared. Results are row ids of the vector as it was
+// when the index was built; the index does not follow later changes.
+template <std::size_t N, typename T>
+class unpack_search_index {
+  public:
+    using key_type = typename std::tuple_element<N, T>::type;
+
+  private:
+    // Nodes 1..size() of the tree, node k having children 2k and 2k + 1;
+    // _keys[0] is unused. _rows[k] is the row of node k.
+    std::vector<key_type> _keys;
+    std::vector<std::size_t> _rows;
+
+    // The descendants log2(stride) levels below node k are the nodes
+    // k * stride onwards, which fill one cache line.
+    static constexpr std::size_t stride = 64 / sizeof(key_type) ? 64 / sizeof(key_type) : 1;
+
+    std::size_t build(const key_type* p, std::size_t row, std::size_t k) {
+      if (k < _keys.size()) {
+        row = build(p, row, 2 * k);
+        _keys[k] = p[row];
+        _rows[k] = row;
+        row = build(p, row + 1, 2 * k + 1);
+        return row;
+      }
+      return row;
+    }
+
+    void prefetch(std::size_t k) const {
+      unpack_prefetch(_keys.data() + std::min(k * stride, _keys.size() - 1));
+    }
+
+    // The node a finished search ends at encodes its path as bits, 1 for
+    // every right turn. Dropping the trailing right turns and the last
+    // left turn gives the last node where the search went left, the one
+    // with the smallest key not less than the searched one, or 0.
+    static std::size_t last_left(std::size_t k) {
+#if defined(__GNUC__)
+      return k >> (__builtin_ctzll(~static_cast<unsigned long long>(k)) + 1);
+#else
+      while (k & 1) {
+        k >>= 1;
+      }
+      return k >> 1;
+#endif
+    }
+
+    std::size_t search(const key_type& key) const {
+      std::size_t k = 1;
+      while (k < _keys.size()) {
+        prefetch(k);
+        k = 2 * k + (_keys[k] < key);
+      }
+      return last_left(k);
+    }
+
+  public:
+    // Throws std::invalid_argument if column N of v is not sorted.
+    explicit unpack_search_index(const std::vector<unpack<T>>& v)
+      : _keys(v.size() + 1), _rows(v.size() + 1)
+    {
+      const key_type* p = v.template data<N>();
+      if (!std::is_sorted(p, p + v.size())) {
+        throw std::invalid_argument("unpack_search_index: column is not sorted");
+      }
+      build(p, 0, 1);
+    }
+
+    std::size_t size() const {
+      return _keys.size() - 1;
+    }
+
+    // First row whose key is not less than key, or size() if there is none.
+    std::size_t lower_bound(const key_type& key) const {
+      std::size_t k = search(key);
+      return k ? _rows[k] : size();
+    }
+
+    // First row whose key equals key, or size() if there is none.
+    std::size_t find(const key_type& key) const {
+      std::size_t k = search(key);
+      return k && !(key < _keys[k]) ? _rows[k] : size();
+    }
+
+    // lower_bound of keys[0, n) into rows. Up to unpack_search_batch
+    // searches advance one level at a time together, so their cache
+    // misses overlap instead of being paid one after another.
+    void lower_bound(const key_type* keys, std::size_t n, std::size_t* rows) const {
+      std::size_t k[unpack_search_batch];
+      for (std::size_t first = 0; first < n; first += unpack_search_batch) {
+        std::size_t m = std::min(unpack_search_batch, n - first);
+        for (std::size_t j = 0; j < m; j++) {
+          k[j] = 1;
+        }
+        bool active = true;
+        while (active) {
+          active = false;
+          for (std::size_t j = 0; j < m; j++) {
+            if (k[j] < _keys.size()) {
+              prefetch(k[j]);
+              k[j] = 2 * k[j] + (_keys[k[j]] < keys[first + j]);
+              active = true;
+            }
+          }
+        }
+        for (std::size_t j = 0; j < m; j++) {
+          std::size_t node = last_left(k[j]);
+          rows[first + j] = node ? _rows[node] : size();
+        }
+      }
+    }
+
+    std::vector<std::size_t> lower_bound(const std::vector<key_type>& keys) const {
+      std::vector<std::size_t> rows(keys.size());
+      lower_bound(keys.data(), keys.size(), rows.data());
+      return rows;
+    }
+};
+
+// Builds the search index of column N of v, which must be sorted.
+template <std::size_t N, typename T>
+unpack_search_index<N, T> search_index(const std::vector<unpack<T>>& v) {
+  return unpack_search_index<N, T>(v);
+}
+
+#endif
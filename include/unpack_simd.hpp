@@ -0,0 +1,299 @@
+#ifndef UNPACK_SIMD
+#define UNPACK_SIMD
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UNPACK_SIMD_DISPATCH 1
+#define UNPACK_SIMD_TARGET(isa) __attribute__((target(isa)))
+#define UNPACK_SIMD_INLINE __attribute__((always_inline)) inline
+#else
+#define UNPACK_SIMD_DISPATCH 0
+#define UNPACK_SIMD_INLINE inline
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define UNPACK_STREAM_STORES 1
+#else
+#define UNPACK_STREAM_STORES 0
+#endif
+
+enum class simd_level { scalar, sse2, avx2, avx512 };
+
+// Widest instruction set the running CPU supports.
+inline simd_level simd_runtime_level() {
+#if UNPACK_SIMD_DISPATCH
+  static const simd_level level = []() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      return simd_level::avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      return simd_level::avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return simd_level::sse2;
+    }
+    return simd_level::scalar;
+  }();
+  return level;
+#else
+  return simd_level::scalar;
+#endif
+}
+
+// Hints that the cache line holding p will be read soon.
+inline void unpack_prefetch(const void* p) {
+#if defined(__GNUC__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
+// Bytes written by one bulk operation above which the vector writes
+// columns with non-temporal stores. Larger writes would evict most of a
+// typical last level cache anyway.
+constexpr std::size_t unpack_stream_bytes = 4 * 1024 * 1024;
+
+// Whether stream_fill and stream_copy use non-temporal stores for X: plain
+// data whose size divides a 16 byte store, at its natural alignment.
+template <typename X>
+struct is_streamable : std::integral_constant<bool, UNPACK_STREAM_STORES
+  && std::is_trivially_copyable<X>::value && std::is_trivially_default_constructible<X>::value
+  && sizeof(X) == alignof(X) && 16 % sizeof(X) == 0> {};
+
+#if UNPACK_STREAM_STORES
+template <typename X>
+void stream_fill(X* p, std::size_t n, const X& value, std::true_type) {
+  for (; n && reinterpret_cast<std::uintptr_t>(p) % 16; n--) {
+    *p++ = value;
+  }
+  constexpr std::size_t per_store = 16 / sizeof(X);
+  X pattern[per_store];
+  std::fill_n(pattern, per_store, value);
+  __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+  std::size_t i = 0;
+  for (; i + per_store <= n; i += per_store) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(p + i), lanes);
+  }
+  std::fill(p + i, p + n, value);
+  _mm_sfence();
+}
+
+template <typename X>
+void stream_copy(X* dst, const X* src, std::size_t n, std::true_type) {
+  for (; n && reinterpret_cast<std::uintptr_t>(dst) % 16; n--) {
+    *dst++ = *src++;
+  }
+  constexpr std::size_t per_store = 16 / sizeof(X);
+  std::size_t i = 0;
+  for (; i + per_store <= n; i += per_store) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+  }
+  std::copy(src + i, src + n, dst + i);
+  _mm_sfence();
+}
+#endif
+
+template <typename X>
+void stream_fill(X* p, std::size_t n, const X& value, std::false_type) {
+  std::fill_n(p, n, value);
+}
+
+template <typename X>
+void stream_copy(X* dst, const X* src, std::size_t n, std::false_type) {
+  std::copy_n(src, n, dst);
+}
+
+// Sets p[0, n) to value with non-temporal stores, which write whole lines
+// to memory without reading them first and without evicting cached data.
+// Plain stores are used when X is not streamable.
+template <typename X>
+void stream_fill(X* p, std::size_t n, const X& value) {
+  stream_fill(p, n, value, is_streamable<X>());
+}
+
+// Copies src[0, n) to dst[0, n), see stream_fill.
+template <typename X>
+void stream_copy(X* dst, const X* src, std::size_t n) {
+  stream_copy(dst, src, n, is_streamable<X>());
+}
+
+// As many lanes of T as fit in a vector register of Bytes bytes, one lane
+// when Bytes is 0 or T is wider than the register. Loops over the lanes
+// have a constant trip count, so they compile to single vector
+// instructions for whatever target the enclosing kernel is built for.
+template <typename T, std::size_t Bytes>
+struct simd_lanes {
+  static constexpr std::size_t size = Bytes / sizeof(T) ? Bytes / sizeof(T) : 1;
+  T lane[size];
+};
+
+// Kernel bodies for one register width. They are always inlined into the
+// per-target wrappers below so that they are compiled for that target.
+// Reductions keep one accumulator per lane, which reorders the operations
+// the way std::reduce is allowed to: op must be associative and
+// commutative.
+template <std::size_t Bytes>
+struct column_kernels {
+  template <typename T>
+  static UNPACK_SIMD_INLINE void fill(T* p, std::size_t n, const T& value) {
+    using lanes = simd_lanes<T, Bytes>;
+    lanes v;
+    for (std::size_t k = 0; k < lanes::size; k++) {
+      v.lane[k] = value;
+    }
+    std::size_t i = 0;
+    for (; i + lanes::size <= n; i += lanes::size) {
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        p[i + k] = v.lane[k];
+      }
+    }
+    for (; i < n; i++) {
+      p[i] = value;
+    }
+  }
+
+  template <typename T, typename F>
+  static UNPACK_SIMD_INLINE void transform(T* p, std::size_t n, F& f) {
+    using lanes = simd_lanes<T, Bytes>;
+    std::size_t i = 0;
+    for (; i + lanes::size <= n; i += lanes::size) {
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        p[i + k] = f(p[i + k]);
+      }
+    }
+    for (; i < n; i++) {
+      p[i] = f(p[i]);
+    }
+  }
+
+  // Stores e[i] to p[i] for i in [first, last). Each block of lanes is
+  // read in full before it is written, so e may read p itself.
+  template <typename T, typename E>
+  static UNPACK_SIMD_INLINE void assign(T* p, std::size_t first, std::size_t last,
+      const E& e) {
+    using lanes = simd_lanes<T, Bytes>;
+    std::size_t i = first;
+    for (; i + lanes::size <= last; i += lanes::size) {
+      lanes v;
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        v.lane[k] = e[i + k];
+      }
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        p[i + k] = v.lane[k];
+      }
+    }
+    for (; i < last; i++) {
+      p[i] = e[i];
+    }
+  }
+
+  template <typename T, typename R, typename Op>
+  static UNPACK_SIMD_INLINE R reduce(const T* p, std::size_t n, R init, Op& op) {
+    using lanes = simd_lanes<R, Bytes>;
+    std::size_t i = 0;
+    if (n >= lanes::size) {
+      lanes acc;
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        acc.lane[k] = p[k];
+      }
+      for (i = lanes::size; i + lanes::size <= n; i += lanes::size) {
+        for (std::size_t k = 0; k < lanes::size; k++) {
+          acc.lane[k] = op(acc.lane[k], p[i + k]);
+        }
+      }
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        init = op(init, acc.lane[k]);
+      }
+    }
+    for (; i < n; i++) {
+      init = op(init, p[i]);
+    }
+    return init;
+  }
+
+  template <typename A, typename B, typename R, typename Reduce, typename Transform>
+  static UNPACK_SIMD_INLINE R transform_reduce(const A* a, const B* b, std::size_t n,
+      R init, Reduce& reduce, Transform& transform) {
+    using lanes = simd_lanes<R, Bytes>;
+    std::size_t i = 0;
+    if (n >= lanes::size) {
+      lanes acc;
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        acc.lane[k] = transform(a[k], b[k]);
+      }
+      for (i = lanes::size; i + lanes::size <= n; i += lanes::size) {
+        for (std::size_t k = 0; k < lanes::size; k++) {
+          acc.lane[k] = reduce(acc.lane[k], transform(a[i + k], b[i + k]));
+        }
+      }
+      for (std::size_t k = 0; k < lanes::size; k++) {
+        init = reduce(init, acc.lane[k]);
+      }
+    }
+    for (; i < n; i++) {
+      init = reduce(init, transform(a[i], b[i]));
+    }
+    return init;
+  }
+};
+
+#if UNPACK_SIMD_DISPATCH
+#define UNPACK_COLUMN_KERNELS_FOR(suffix, isa, bytes) \
+  template <typename T> \
+  UNPACK_SIMD_TARGET(isa) void column_fill_##suffix(T* p, std::size_t n, const T& value) { \
+    column_kernels<bytes>::fill(p, n, value); \
+  } \
+  template <typename T, typename F> \
+  UNPACK_SIMD_TARGET(isa) void column_transform_##suffix(T* p, std::size_t n, F& f) { \
+    column_kernels<bytes>::transform(p, n, f); \
+  } \
+  template <typename T, typename E> \
+  UNPACK_SIMD_TARGET(isa) void column_assign_##suffix(T* p, std::size_t first, \
+      std::size_t last, const E& e) { \
+    column_kernels<bytes>::assign(p, first, last, e); \
+  } \
+  template <typename T, typename R, typename Op> \
+  UNPACK_SIMD_TARGET(isa) R column_reduce_##suffix(const T* p, std::size_t n, R init, Op& op) { \
+    return column_kernels<bytes>::reduce(p, n, init, op); \
+  } \
+  template <typename A, typename B, typename R, typename Reduce, typename Transform> \
+  UNPACK_SIMD_TARGET(isa) R column_transform_reduce_##suffix(const A* a, const B* b, \
+      std::size_t n, R init, Reduce& reduce, Transform& transform) { \
+    return column_kernels<bytes>::transform_reduce(a, b, n, init, reduce, transform); \
+  }
+
+UNPACK_COLUMN_KERNELS_FOR(sse2, "sse2", 16)
+UNPACK_COLUMN_KERNELS_FOR(avx2, "avx2", 32)
+UNPACK_COLUMN_KERNELS_FOR(avx512, "avx512f", 64)
+
+#undef UNPACK_COLUMN_KERNELS_FOR
+#endif
+
+// Runs the kernel for `level`, lowered to what the CPU supports.
+#if UNPACK_SIMD_DISPATCH
+#define UNPACK_COLUMN_DISPATCH(level, kernel, ...) \
+  switch (std::min(level, simd_runtime_level())) { \
+    case simd_level::avx512: \
+      return column_##kernel##_avx512(__VA_ARGS__); \
+    case simd_level::avx2: \
+      return column_##kernel##_avx2(__VA_ARGS__); \
+    case simd_level::sse2: \
+      return column_##kernel##_sse2(__VA_ARGS__); \
+    default: \
+      return column_kernels<0>::kernel(__VA_ARGS__); \
+  }
+#else
+#define UNPACK_COLUMN_DISPATCH(level, kernel, ...) \
+  (void)level; \
+  return column_kernels<0>::kernel(__VA_ARGS__);
+#endif
+
+#endif
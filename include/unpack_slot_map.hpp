@@ -0,0 +1,252 @@
+#ifndef UNPACK_SLOT_MAP
+#define UNPACK_SLOT_MAP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "unpack_vector.hpp"
+
+// Stable reference to a row of a slot_map. A handle stays valid until its
+// row is erased, however the rows are reordered, and never refers to a
+// later row reusing the slot: the generation tells them apart.
+struct unpack_handle {
+  std::uint32_t slot;
+  std::uint32_t generation;
+
+  friend bool operator==(const unpack_handle& lhs, const unpack_handle& rhs) {
+    return lhs.slot == rhs.slot && lhs.generation == rhs.generation;
+  }
+
+  friend bool operator!=(const unpack_handle& lhs, const unpack_handle& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+template <typename T>
+class slot_map;
+
+// Rows of a vector<unpack<T>> addressed by handles. The rows stay dense:
+// erase moves the last row into the hole, so iterating rows and columns is
+// as fast as over the vector itself, and a sparse table of slots maps each
+// handle to its current row. Insert, erase and lookup are O(1). Row
+// indices, iterators and pointers into columns are invalidated by insert
+// and erase; handles are not. Rows may be changed in place through the
+// iterators, but not reordered.
+template <typename T>
+class slot_map<unpack<T>> {
+  private:
+    using tuple_refs_type = typename unpack_tuple_refs_type<T>::type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+
+    struct slot {
+      // Row of a live slot, or the next free slot of a free one.
+      std::uint32_t index;
+      std::uint32_t generation;
+    };
+
+    static constexpr std::uint32_t no_slot = std::uint32_t(-1);
+
+    std::vector<unpack<T>> _rows;
+    // Slot of each row, to redirect it when erase moves the row.
+    std::vector<std::uint32_t> _row_slots;
+    std::vector<slot> _slots;
+    std::uint32_t _free;
+
+    // Gives the row just appended at the end a slot, or removes it again
+    // if that fails.
+    unpack_handle acquire() {
+      try {
+        return acquire_slot();
+      } catch (...) {
+        _rows.pop_back();
+        throw;
+      }
+    }
+
+    unpack_handle acquire_slot() {
+      std::uint32_t s = _free;
+      if (s == no_slot) {
+        if (_slots.size() == no_slot) {
+          throw std::length_error("slot_map: out of slots");
+        }
+        s = static_cast<std::uint32_t>(_slots.size());
+        _slots.push_back(slot{ 0, 0 });
+      } else {
+        _free = _slots[s].index;
+      }
+      _row_slots.push_back(s);
+      _slots[s].index = static_cast<std::uint32_t>(_rows.size() - 1);
+      return unpack_handle{ s, _slots[s].generation };
+    }
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = typename std::vector<unpack<T>>::iterator;
+    using const_iterator = typename std::vector<unpack<T>>::const_iterator;
+
+    slot_map() : _free(no_slot) {}
+
+    std::size_t size() const {
+      return _rows.size();
+    }
+
+    bool empty() const {
+      return _rows.empty();
+    }
+
+    void reserve(std::size_t size) {
+      _rows.reserve(size);
+      _row_slots.reserve(size);
+      _slots.reserve(size);
+    }
+
+    unpack_handle insert(const T& row) {
+      _rows.push_back(row);
+      return acquire();
+    }
+
+    template <typename ... Args>
+    unpack_handle emplace(Args&& ... args) {
+      _rows.emplace_back(std::forward<Args>(args) ...);
+      return acquire();
+    }
+
+    bool contains(unpack_handle handle) const {
+      return handle.slot < _slots.size() && _slots[handle.slot].generation == handle.generation
+        && _slots[handle.slot].index < _rows.size()
+        && _row_slots[_slots[handle.slot].index] == handle.slot;
+    }
+
+    // Erases the row of handle, if it is still there, by moving the last
+    // row into its place. Returns whether a row was erased.
+    bool erase(unpack_handle handle) {
+      if (!contains(handle)) {
+        return false;
+      }
+      std::uint32_t index = _slots[handle.slot].index;
+      std::uint32_t last = static_cast<std::uint32_t>(_rows.size() - 1);
+      if (index != last) {
+        _rows[index] = _rows[last];
+        _row_slots[index] = _row_slots[last];
+        _slots[_row_slots[index]].index = index;
+      }
+      _rows.pop_back();
+      _row_slots.pop_back();
+      _slots[handle.slot].generation++;
+      _slots[handle.slot].index = _free;
+      _free = handle.slot;
+      return true;
+    }
+
+    // Erases every row; all handles become invalid.
+    void clear() {
+      while (!_rows.empty()) {
+        std::uint32_t s = _row_slots.back();
+        _slots[s].generation++;
+        _slots[s].index = _free;
+        _free = s;
+        _rows.pop_back();
+        _row_slots.pop_back();
+      }
+    }
+
+    // Row of handle, which must be valid.
+    std::size_t index(unpack_handle handle) const {
+      return _slots[handle.slot].index;
+    }
+
+    // Handle of row index.
+    unpack_handle handle(std::size_t index) const {
+      std::uint32_t s = _row_slots[index];
+      return unpack_handle{ s, _slots[s].generation };
+    }
+
+    tuple_refs_type operator[](unpack_handle handle) {
+      return _rows[index(handle)];
+    }
+
+    tuple_const_refs_type operator[](unpack_handle handle) const {
+      return _rows[index(handle)];
+    }
+
+    // Throws std::out_of_range if the row of handle was erased.
+    tuple_refs_type at(unpack_handle handle) {
+      if (!contains(handle)) {
+        throw std::out_of_range("slot_map::at: stale handle");
+      }
+      return _rows[index(handle)];
+    }
+
+    tuple_const_refs_type at(unpack_handle handle) const {
+      if (!contains(handle)) {
+        throw std::out_of_range("slot_map::at: stale handle");
+      }
+      return _rows[index(handle)];
+    }
+
+    // The dense rows, in no particular order.
+    const std::vector<unpack<T>>& rows() const {
+      return _rows;
+    }
+
+    template <std::size_t N>
+    auto data() {
+      return _rows.template data<N>();
+    }
+
+    template <std::size_t N>
+    auto data() const {
+      return _rows.template data<N>();
+    }
+
+    iterator begin() {
+      return _rows.begin();
+    }
+
+    iterator end() {
+      return _rows.end();
+    }
+
+    const_iterator begin() const {
+      return _rows.begin();
+    }
+
+    const_iterator end() const {
+      return _rows.end();
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+    template <std::size_t N>
+    auto begin() {
+      return _rows.template begin<N>();
+    }
+
+    template <std::size_t N>
+    auto end() {
+      return _rows.template end<N>();
+    }
+
+    template <std::size_t N>
+    auto begin() const {
+      return _rows.template begin<N>();
+    }
+
+    template <std::size_t N>
+    auto end() const {
+      return _rows.template end<N>();
+    }
+};
+
+#endif
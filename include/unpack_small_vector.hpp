@@ -0,0 +1,460 @@
+#ifndef UNPACK_SMALL_VECTOR
+#define UNPACK_SMALL_VECTOR
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "unpack_details.hpp"
+#include "unpack_iterator.hpp"
+
+// One column of a small_vector: room for K elements inside the object,
+// moving to the heap once more are needed.
+template <typename X, std::size_t K>
+class unpack_small_column {
+  private:
+    typename std::aligned_storage<sizeof(X), alignof(X)>::type _inline[K ? K : 1];
+    X* _data;
+    std::size_t _size;
+    std::size_t _capacity;
+
+    X* inline_data() {
+      return reinterpret_cast<X*>(_inline);
+    }
+
+    void release() {
+      clear();
+      if (!is_inline()) {
+        std::allocator<X>().deallocate(_data, _capacity);
+      }
+      _data = inline_data();
+      _capacity = K;
+    }
+
+    // Takes the elements of c, stealing its heap buffer if it has one.
+    void take(unpack_small_column& c) {
+      if (c.is_inline()) {
+        for (std::size_t i = 0; i < c._size; i++) {
+          ::new (static_cast<void*>(_data + i)) X(std::move(c._data[i]));
+        }
+        _size = c._size;
+        c.clear();
+      } else {
+        _data = c._data;
+        _size = c._size;
+        _capacity = c._capacity;
+        c._data = c.inline_data();
+        c._size = 0;
+        c._capacity = K;
+      }
+    }
+
+  public:
+    unpack_small_column() : _data(inline_data()), _size(0), _capacity(K) {}
+
+    unpack_small_column(const unpack_small_column& c) : unpack_small_column() {
+      reserve(c._size);
+      for (std::size_t i = 0; i < c._size; i++) {
+        push_back(c._data[i]);
+      }
+    }
+
+    unpack_small_column(unpack_small_column&& c) : unpack_small_column() {
+      take(c);
+    }
+
+    unpack_small_column& operator=(const unpack_small_column& c) {
+      if (this != &c) {
+        clear();
+        reserve(c._size);
+        for (std::size_t i = 0; i < c._size; i++) {
+          push_back(c._data[i]);
+        }
+      }
+      return *this;
+    }
+
+    unpack_small_column& operator=(unpack_small_column&& c) {
+      if (this != &c) {
+        release();
+        take(c);
+      }
+      return *this;
+    }
+
+    ~unpack_small_column() {
+      release();
+    }
+
+    bool is_inline() const {
+      return _data == reinterpret_cast<const X*>(_inline);
+    }
+
+    std::size_t size() const {
+      return _size;
+    }
+
+    std::size_t capacity() const {
+      return _capacity;
+    }
+
+    X* data() {
+      return _data;
+    }
+
+    const X* data() const {
+      return _data;
+    }
+
+    X* begin() {
+      return _data;
+    }
+
+    X* end() {
+      return _data + _size;
+    }
+
+    const X* begin() const {
+      return _data;
+    }
+
+    const X* end() const {
+      return _data + _size;
+    }
+
+    X& operator[](std::size_t index) {
+      return _data[index];
+    }
+
+    const X& operator[](std::size_t index) const {
+      return _data[index];
+    }
+
+    void reserve(std::size_t capacity) {
+      if (capacity <= _capacity) {
+        return;
+      }
+      X* data = std::allocator<X>().allocate(capacity);
+      for (std::size_t i = 0; i < _size; i++) {
+        ::new (static_cast<void*>(data + i)) X(std::move_if_noexcept(_data[i]));
+        _data[i].~X();
+      }
+      if (!is_inline()) {
+        std::allocator<X>().deallocate(_data, _capacity);
+      }
+      _data = data;
+      _capacity = capacity;
+    }
+
+    template <typename ... Args>
+    void emplace_back(Args&& ... args) {
+      if (_size == _capacity) {
+        // args may refer to an element, which growing would move.
+        X value(std::forward<Args>(args) ...);
+        reserve(std::max<std::size_t>(2 * _capacity, 1));
+        ::new (static_cast<void*>(_data + _size)) X(std::move(value));
+      } else {
+        ::new (static_cast<void*>(_data + _size)) X(std::forward<Args>(args) ...);
+      }
+      _size++;
+    }
+
+    void push_back(const X& value) {
+      emplace_back(value);
+    }
+
+    void push_back(X&& value) {
+      emplace_back(std::move(value));
+    }
+
+    void pop_back() {
+      _data[--_size].~X();
+    }
+
+    void clear() {
+      while (_size) {
+        pop_back();
+      }
+    }
+
+    void resize(std::size_t size) {
+      reserve(size);
+      while (_size > size) {
+        pop_back();
+      }
+      for (; _size < size; _size++) {
+        ::new (static_cast<void*>(_data + _size)) X();
+      }
+    }
+
+    void resize(std::size_t size, const X& value) {
+      while (_size > size) {
+        pop_back();
+      }
+      while (_size < size) {
+        push_back(value);
+      }
+    }
+
+    template <typename V>
+    void insert(std::size_t index, V&& value) {
+      emplace_back(std::forward<V>(value));
+      std::rotate(begin() + index, end() - 1, end());
+    }
+
+    void erase(std::size_t first, std::size_t last) {
+      std::move(begin() + last, end(), begin() + first);
+      for (std::size_t i = first; i < last; i++) {
+        pop_back();
+      }
+    }
+};
+
+template <typename T, std::size_t K, typename Indices>
+struct small_vector_types_helper;
+
+template <typename T, std::size_t K, std::size_t ... Indices>
+struct small_vector_types_helper<T, K, std::index_sequence<Indices ...>> {
+  using data_type = std::tuple<unpack_small_column<typename std::tuple_element<Indices, T>::type, K> ...>;
+  using iters_type = std::tuple<typename std::tuple_element<Indices, T>::type* ...>;
+  using const_iters_type = std::tuple<const typename std::tuple_element<Indices, T>::type* ...>;
+};
+
+template <typename T, std::size_t K>
+struct small_vector_types {
+  using Indices = std::make_index_sequence<std::tuple_size<T>::value>;
+  using data_type = typename small_vector_types_helper<T, K, Indices>::data_type;
+  using iters_type = typename small_vector_types_helper<T, K, Indices>::iters_type;
+  using const_iters_type = typename small_vector_types_helper<T, K, Indices>::const_iters_type;
+};
+
+template <typename T, std::size_t K>
+class small_vector;
+
+// A vector<unpack<T>> keeping up to K rows inside the object, in one
+// inline array per column, so that small vectors need no allocation. Once
+// a column outgrows K rows it moves to the heap; all columns grow together.
+// Offers the row and column access of vector<unpack<T>>, with the same
+// iterator and reference types over raw column pointers.
+template <typename T, std::size_t K>
+class small_vector<unpack<T>, K> {
+  private:
+    using types = small_vector_types<T, K>;
+    using tuple_refs_type = typename unpack_tuple_refs_type<T>::type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+    typename types::data_type _data;
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = unpack_iterator<typename types::iters_type>;
+    using const_iterator = unpack_const_iterator<typename types::const_iters_type>;
+
+    small_vector() {}
+
+    explicit small_vector(std::size_t size) {
+      resize(size);
+    }
+
+    small_vector(std::initializer_list<T> ilist) {
+      reserve(ilist.size());
+      for (auto& tuple : ilist) {
+        push_back(tuple);
+      }
+    }
+
+    // Whether the rows are still held inside the object.
+    bool is_inline() const {
+      return std::get<0>(_data).is_inline();
+    }
+
+    std::size_t size() const {
+      return std::get<0>(_data).size();
+    }
+
+    std::size_t capacity() const {
+      return std::get<0>(_data).capacity();
+    }
+
+    bool empty() const {
+      return size() == 0;
+    }
+
+    void reserve(std::size_t size) {
+      tuple_for_each([size](auto& cur_col) { cur_col.reserve(size); }, _data);
+    }
+
+    void assign(std::size_t count, const T& value) {
+      clear();
+      resize(count, value);
+    }
+
+    void push_back(const T& elem) {
+      tuple_for_each([](auto& new_elem, auto& cur_col) {
+        cur_col.push_back(new_elem);
+      }, elem, _data);
+    }
+
+    template <typename ... Args>
+    tuple_refs_type emplace_back(Args&& ... args) {
+      tuple_for_each([](auto&& _args, auto& cur_col) {
+        cur_col.emplace_back(std::forward<decltype(_args)>(_args));
+      }, std::make_tuple(std::forward<Args>(args) ...), _data);
+      return back();
+    }
+
+    void pop_back() {
+      tuple_for_each([](auto& cur_col) { cur_col.pop_back(); }, _data);
+    }
+
+    void clear() {
+      tuple_for_each([](auto& cur_col) { cur_col.clear(); }, _data);
+    }
+
+    void resize(std::size_t size) {
+      tuple_for_each([size](auto& cur_col) { cur_col.resize(size); }, _data);
+    }
+
+    void resize(std::size_t size, const T& value) {
+      tuple_for_each([size](auto& cur_col, auto& cur_elem) {
+        cur_col.resize(size, cur_elem);
+      }, _data, value);
+    }
+
+    iterator insert(const_iterator pos, const T& value) {
+      std::size_t index = pos - cbegin();
+      tuple_for_each([index](auto& cur_col, auto& cur_elem) {
+        cur_col.insert(index, cur_elem);
+      }, _data, value);
+      return begin() + index;
+    }
+
+    iterator erase(const_iterator pos) {
+      return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+      std::size_t index = first - cbegin();
+      std::size_t end_index = last - cbegin();
+      tuple_for_each([index, end_index](auto& cur_col) {
+        cur_col.erase(index, end_index);
+      }, _data);
+      return begin() + index;
+    }
+
+    void swap(small_vector& v) {
+      std::swap(_data, v._data);
+    }
+
+    tuple_refs_type operator[](std::size_t index) {
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_const_refs_type operator[](std::size_t index) const {
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_refs_type at(std::size_t index) {
+      throw_if_out_of_bounds(index, size());
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_const_refs_type at(std::size_t index) const {
+      throw_if_out_of_bounds(index, size());
+      return tuple_r_at_index(_data, index);
+    }
+
+    tuple_refs_type front() {
+      return operator[](0);
+    }
+
+    tuple_const_refs_type front() const {
+      return operator[](0);
+    }
+
+    tuple_refs_type back() {
+      return operator[](size() - 1);
+    }
+
+    tuple_const_refs_type back() const {
+      return operator[](size() - 1);
+    }
+
+    template <std::size_t N>
+    auto data() {
+      return std::get<N>(_data).data();
+    }
+
+    template <std::size_t N>
+    auto data() const {
+      return std::get<N>(_data).data();
+    }
+
+    iterator begin() {
+      return iterator(make_tuple_vec_iter(_data, [](auto& col) { return col.begin(); }));
+    }
+
+    iterator end() {
+      return iterator(make_tuple_vec_iter(_data, [](auto& col) { return col.end(); }));
+    }
+
+    const_iterator begin() const {
+      return const_iterator(make_tuple_vec_const_iter(_data,
+            [](auto& col) { return col.begin(); }));
+    }
+
+    const_iterator end() const {
+      return const_iterator(make_tuple_vec_const_iter(_data,
+            [](auto& col) { return col.end(); }));
+    }
+
+    const_iterator cbegin() const {
+      return begin();
+    }
+
+    const_iterator cend() const {
+      return end();
+    }
+
+    template <std::size_t N>
+    auto begin() {
+      return std::get<N>(_data).begin();
+    }
+
+    template <std::size_t N>
+    auto end() {
+      return std::get<N>(_data).end();
+    }
+
+    template <std::size_t N>
+    auto begin() const {
+      return std::get<N>(_data).begin();
+    }
+
+    template <std::size_t N>
+    auto end() const {
+      return std::get<N>(_data).end();
+    }
+
+    friend void swap(small_vector& lhs, small_vector& rhs) {
+      lhs.swap(rhs);
+    }
+};
+
+template <typename T, std::size_t K>
+bool operator==(const small_vector<unpack<T>, K>& lhs, const small_vector<unpack<T>, K>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, std::size_t K>
+bool operator!=(const small_vector<unpack<T>, K>& lhs, const small_vector<unpack<T>, K>& rhs) {
+  return !(lhs == rhs);
+}
+
+#endif
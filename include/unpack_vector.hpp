@@ -3,8 +3,11 @@
 
 #include <vector>
 #include <iostream>
+#include <type_traits>
 #include "unpack_iterator.hpp"
 #include "unpack_details.hpp"
+#include "unpack_expression.hpp"
+#include "unpack_simd.hpp"
 
 namespace std
 {
@@ -19,6 +22,86 @@ class vector<unpack<T>> {
     using tuple_vec_const_iter_type = typename unpack_tuple_vec_const_iter_type<T>::type;
     data_type _data;
 
+    // Whether writing `rows` rows is large enough to bypass the cache.
+    static bool streams(size_t rows) {
+      return rows * unpack_row_bytes<T>::value >= unpack_stream_bytes;
+    }
+
+    template <typename X>
+    static void assign_column(unpack_column_vector<X>& column, size_t count, const X& value,
+        std::true_type) {
+      column.clear();
+      column.resize(count);
+      stream_fill(column.data(), count, value);
+    }
+
+    template <typename X>
+    static void assign_column(unpack_column_vector<X>& column, size_t count, const X& value,
+        std::false_type) {
+      column.assign(count, value);
+    }
+
+    template <typename X>
+    static void copy_column(unpack_column_vector<X>& column, const unpack_column_vector<X>& from,
+        std::true_type) {
+      column.clear();
+      column.resize(from.size());
+      stream_copy(column.data(), from.data(), from.size());
+    }
+
+    template <typename X>
+    static void copy_column(unpack_column_vector<X>& column, const unpack_column_vector<X>& from,
+        std::false_type) {
+      column = from;
+    }
+
+    template <typename X>
+    static void resize_column(unpack_column_vector<X>& column, size_t size, const X& value,
+        std::true_type) {
+      size_t old_size = column.size();
+      column.resize(size);
+      stream_fill(column.data() + old_size, size - old_size, value);
+    }
+
+    template <typename X>
+    static void resize_column(unpack_column_vector<X>& column, size_t size, const X& value,
+        std::false_type) {
+      column.resize(size, value);
+    }
+
+    // Value-initializes new elements: explicitly for trivial elements, which
+    // the column allocator would leave unwritten, by the allocator otherwise.
+    template <typename X>
+    static void value_resize_column(unpack_column_vector<X>& column, size_t size, bool stream,
+        std::true_type) {
+      if (stream) {
+        resize_column(column, size, X(), is_streamable<X>());
+      } else {
+        column.resize(size, X());
+      }
+    }
+
+    template <typename X>
+    static void value_resize_column(unpack_column_vector<X>& column, size_t size, bool,
+        std::false_type) {
+      column.resize(size);
+    }
+
+    void copy_from(const vector<unpack<T>>& v) {
+      if (this == &v) {
+        return;
+      }
+      bool stream = streams(v.size());
+      tuple_for_each([stream](auto& _old, auto& _new) {
+        using X = typename std::decay_t<decltype(_new)>::value_type;
+        if (stream) {
+          copy_column(_new, _old, is_streamable<X>());
+        } else {
+          _new = _old;
+        }
+      }, v._data, _data);
+    }
+
   public:
     using value_type = T;
     using size_type = size_t;
@@ -30,10 +113,10 @@ class vector<unpack<T>> {
 
     vector<unpack<T>>() {}
 
+    // Copies of large vectors write columns with non-temporal stores, see
+    // unpack_stream_bytes; so do assign and growing resize.
     vector<unpack<T>>(const vector<unpack<T>>& v) {
-      tuple_for_each([](auto& _old, auto& _new) {
-        _new = _old;
-      }, v._data, _data);
+      copy_from(v);
     }
 
     vector<unpack<T>>(vector<unpack<T>>&& v) {
@@ -52,10 +135,12 @@ class vector<unpack<T>> {
       resize(size);
     }
 
+    vector<unpack<T>> (std::size_t size, unpack_default_init_t) {
+      resize(size, unpack_default_init);
+    }
+
     vector<unpack<T>>& operator=(const vector<unpack<T>>& v) {
-      tuple_for_each([](auto& _old, auto& _new) {
-        _new = _old;
-      }, v._data, _data);
+      copy_from(v);
       return *this;
     }
 
@@ -75,8 +160,14 @@ class vector<unpack<T>> {
     }
 
     void assign(size_t count, const T& value) {
-      tuple_for_each([count](auto& cur_vect, auto& cur_elem) {
-        cur_vect.assign(count, cur_elem);
+      bool stream = streams(count);
+      tuple_for_each([count, stream](auto& cur_vect, auto& cur_elem) {
+        using X = typename std::decay_t<decltype(cur_vect)>::value_type;
+        if (stream) {
+          assign_column(cur_vect, count, cur_elem, is_streamable<X>());
+        } else {
+          cur_vect.assign(count, cur_elem);
+        }
       }, _data, value);
     }
 
@@ -224,15 +315,33 @@ class vector<unpack<T>> {
     }
 
     void resize(size_t size) {
-      tuple_for_each([size](auto& cur_vect) { cur_vect.resize(size); }, _data);
+      bool stream = size > this->size() && streams(size - this->size());
+      tuple_for_each([size, stream](auto& cur_vect) {
+        using X = typename std::decay_t<decltype(cur_vect)>::value_type;
+        value_resize_column(cur_vect, size, stream, std::is_trivially_default_constructible<X>());
+      }, _data);
     }
 
     void resize(size_t size, const T& value) {
-      tuple_for_each([size](auto& cur_vect, auto& cur_elem) {
-        cur_vect.resize(size, cur_elem);
+      bool stream = size > this->size() && streams(size - this->size());
+      tuple_for_each([size, stream](auto& cur_vect, auto& cur_elem) {
+        using X = typename std::decay_t<decltype(cur_vect)>::value_type;
+        if (stream) {
+          resize_column(cur_vect, size, cur_elem, is_streamable<X>());
+        } else {
+          cur_vect.resize(size, cur_elem);
+        }
       }, _data, value);
     }
 
+    // Grows columns of trivially default constructible elements without
+    // writing the new elements, whose values are indeterminate until
+    // assigned; the pages behind them are first touched when written.
+    // Other columns value-initialize their new elements as with resize(size).
+    void resize(size_t size, unpack_default_init_t) {
+      tuple_for_each([size](auto& cur_vect) { cur_vect.resize(size); }, _data);
+    }
+
     void shrink_to_fit() {
       tuple_for_each([](auto& cur_vect) { cur_vect.shrink_to_fit(); }, _data);
     }
@@ -271,6 +380,28 @@ class vector<unpack<T>> {
       return operator[](size() - 1);
     }
 
+    template <std::size_t N>
+    auto data() {
+      return std::get<N>(_data).data();
+    }
+
+    template <std::size_t N>
+    auto data() const {
+      return std::get<N>(_data).data();
+    }
+
+    // Column N as an operand of lazy column expressions, e.g.
+    // v.col<0>() = v.col<1>() * v.col<2>() + 1;
+    template <std::size_t N>
+    auto col() {
+      return unpack_column<typename std::tuple_element<N, T>::type>(data<N>(), size());
+    }
+
+    template <std::size_t N>
+    auto col() const {
+      return unpack_column<const typename std::tuple_element<N, T>::type>(data<N>(), size());
+    }
+
     iterator begin() {
       return iterator(make_tuple_vec_iter(_data, [](auto& iter) { return iter.begin(); }));
     }
@@ -0,0 +1,288 @@
+#ifndef UNPACK_VERSIONED_VECTOR
+#define UNPACK_VERSIONED_VECTOR
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "unpack_parallel.hpp"
+#include "unpack_vector.hpp"
+
+// Rows per chunk of a versioned_vector, the granularity of copy-on-write.
+constexpr std::size_t unpack_version_chunk_rows = 4096;
+
+// Readers that can hold a snapshot of one versioned_vector at once; more
+// wait for a snapshot to be released.
+constexpr std::size_t unpack_epoch_slots = 64;
+
+// Epoch-based reclamation for one writer and many readers. A reader pins
+// the current epoch in a slot before reading shared state and clears the
+// slot when done; the writer retires what it unpublished under the epoch
+// it then ends, and frees it once every pinned slot is past that epoch.
+class unpack_epoch_domain {
+  private:
+    struct alignas(unpack_cache_line_size) slot {
+      std::atomic<std::uint64_t> epoch;
+    };
+
+    std::atomic<std::uint64_t> _epoch;
+    slot _slots[unpack_epoch_slots];
+
+  public:
+    unpack_epoch_domain() : _epoch(1) {
+      for (auto& s : _slots) {
+        s.epoch.store(0);
+      }
+    }
+
+    unpack_epoch_domain(const unpack_epoch_domain&) = delete;
+    unpack_epoch_domain& operator=(const unpack_epoch_domain&) = delete;
+
+    // Pins the current epoch and returns the slot holding it. Shared state
+    // must be loaded after pinning.
+    std::size_t pin() {
+      for (std::size_t i = 0; ; i = (i + 1) % unpack_epoch_slots) {
+        std::uint64_t idle = 0;
+        if (_slots[i].epoch.load() == 0
+            && _slots[i].epoch.compare_exchange_strong(idle, _epoch.load())) {
+          return i;
+        }
+        if (i == unpack_epoch_slots - 1) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    void unpin(std::size_t slot) {
+      _slots[slot].epoch.store(0);
+    }
+
+    // Ends the current epoch, after the writer unpublished what it
+    // retires, and returns it.
+    std::uint64_t advance() {
+      return _epoch.fetch_add(1);
+    }
+
+    // Whether something retired under `epoch` may still be read.
+    bool pinned(std::uint64_t epoch) const {
+      for (const auto& s : _slots) {
+        std::uint64_t pinned = s.epoch.load();
+        if (pinned != 0 && pinned <= epoch) {
+          return true;
+        }
+      }
+      return false;
+    }
+};
+
+template <typename T>
+struct unpack_version {
+  using chunk_type = std::vector<unpack<T>>;
+
+  std::vector<std::shared_ptr<const chunk_type>> chunks;
+  std::size_t size;
+};
+
+template <typename T>
+class versioned_vector;
+
+// An immutable view of a versioned_vector as of its last commit before the
+// snapshot was taken. Holds a pinned epoch until destroyed, which keeps the
+// writer from freeing the rows it reads; release snapshots promptly.
+template <typename T>
+class unpack_snapshot {
+  private:
+    using version_type = unpack_version<T>;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+
+    unpack_epoch_domain* _domain;
+    std::size_t _slot;
+    const version_type* _version;
+
+    unpack_snapshot(unpack_epoch_domain& domain, const std::atomic<const version_type*>& current)
+      : _domain(&domain), _slot(domain.pin()), _version(current.load())
+    {
+    }
+
+    friend class versioned_vector<unpack<T>>;
+
+  public:
+    unpack_snapshot(const unpack_snapshot&) = delete;
+    unpack_snapshot& operator=(const unpack_snapshot&) = delete;
+
+    unpack_snapshot(unpack_snapshot&& s)
+      : _domain(s._domain), _slot(s._slot), _version(s._version)
+    {
+      s._domain = nullptr;
+    }
+
+    ~unpack_snapshot() {
+      if (_domain) {
+        _domain->unpin(_slot);
+      }
+    }
+
+    std::size_t size() const {
+      return _version->size;
+    }
+
+    bool empty() const {
+      return size() == 0;
+    }
+
+    tuple_const_refs_type operator[](std::size_t index) const {
+      return (*_version->chunks[index / unpack_version_chunk_rows])
+        [index % unpack_version_chunk_rows];
+    }
+
+    tuple_const_refs_type at(std::size_t index) const {
+      throw_if_out_of_bounds(index, size());
+      return operator[](index);
+    }
+
+    // Calls f(data, rows) for the contiguous parts of column N, in row
+    // order.
+    template <std::size_t N, typename F>
+    void for_each_chunk(F&& f) const {
+      for (const auto& chunk : _version->chunks) {
+        f(chunk->template data<N>(), chunk->size());
+      }
+    }
+};
+
+// A vector<unpack<T>> with one writer and any number of concurrent
+// readers. Rows live in chunks of unpack_version_chunk_rows rows, each a
+// vector<unpack<T>>. The writer changes a private draft and publishes it
+// with commit(); a reader's snapshot() sees the last published version,
+// costs O(1) and never blocks the writer. The draft shares chunks with the
+// published versions and copies a chunk the first time it changes one
+// after a commit. Versions no snapshot can see anymore, and the chunks
+// only they used, are freed on later commits.
+template <typename T>
+class versioned_vector<unpack<T>> {
+  private:
+    using version_type = unpack_version<T>;
+    using chunk_type = typename version_type::chunk_type;
+    using tuple_const_refs_type = typename unpack_tuple_const_refs_type<T>::type;
+
+    mutable unpack_epoch_domain _domain;
+    std::atomic<const version_type*> _current;
+    std::vector<std::pair<std::uint64_t, const version_type*>> _retired;
+
+    std::vector<std::shared_ptr<chunk_type>> _chunks;
+    // Whether the draft chunk was created or copied since the last commit,
+    // so no version shares it.
+    std::vector<bool> _owned;
+    std::size_t _size;
+
+    // Chunk k of the draft, copied first if a published version shares it.
+    chunk_type& writable(std::size_t k) {
+      if (!_owned[k]) {
+        _chunks[k] = std::make_shared<chunk_type>(*_chunks[k]);
+        _owned[k] = true;
+      }
+      return *_chunks[k];
+    }
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using snapshot_type = unpack_snapshot<T>;
+
+    versioned_vector() : _current(new version_type{ {}, 0 }), _size(0) {}
+
+    versioned_vector(const versioned_vector&) = delete;
+    versioned_vector& operator=(const versioned_vector&) = delete;
+
+    // No snapshot may outlive the vector.
+    ~versioned_vector() {
+      for (auto& retired : _retired) {
+        delete retired.second;
+      }
+      delete _current.load();
+    }
+
+    // Safe to call from any thread, concurrently with the writer.
+    snapshot_type snapshot() const {
+      return snapshot_type(_domain, _current);
+    }
+
+    // The writer's functions below are not thread safe among themselves;
+    // they read and change the draft.
+
+    std::size_t size() const {
+      return _size;
+    }
+
+    bool empty() const {
+      return _size == 0;
+    }
+
+    tuple_const_refs_type operator[](std::size_t index) const {
+      return (*_chunks[index / unpack_version_chunk_rows])[index % unpack_version_chunk_rows];
+    }
+
+    void push_back(const T& row) {
+      if (_size % unpack_version_chunk_rows == 0) {
+        _chunks.push_back(std::make_shared<chunk_type>());
+        _chunks.back()->reserve(unpack_version_chunk_rows);
+        _owned.push_back(true);
+      }
+      writable(_chunks.size() - 1).push_back(row);
+      _size++;
+    }
+
+    void pop_back() {
+      _size--;
+      if (_size % unpack_version_chunk_rows == 0) {
+        _chunks.pop_back();
+        _owned.pop_back();
+      } else {
+        writable(_chunks.size() - 1).pop_back();
+      }
+    }
+
+    void set(std::size_t index, const T& row) {
+      writable(index / unpack_version_chunk_rows)[index % unpack_version_chunk_rows] = row;
+    }
+
+    template <std::size_t N>
+    void set(std::size_t index, const typename std::tuple_element<N, T>::type& value) {
+      std::get<N>(writable(index / unpack_version_chunk_rows)
+          [index % unpack_version_chunk_rows]) = value;
+    }
+
+    // Publishes the draft to snapshots taken from now on, then frees the
+    // versions no snapshot can see anymore.
+    void commit() {
+      auto version = new version_type{ { _chunks.begin(), _chunks.end() }, _size };
+      const version_type* old = _current.exchange(version);
+      _retired.emplace_back(_domain.advance(), old);
+      std::fill(_owned.begin(), _owned.end(), false);
+      reclaim();
+    }
+
+    // Frees retired versions no snapshot can see anymore.
+    void reclaim() {
+      auto first = std::partition(_retired.begin(), _retired.end(), [this](const auto& retired) {
+        return _domain.pinned(retired.first);
+      });
+      for (auto it = first; it != _retired.end(); ++it) {
+        delete it->second;
+      }
+      _retired.erase(first, _retired.end());
+    }
+
+    // Versions retired but not yet freed.
+    std::size_t retired() const {
+      return _retired.size();
+    }
+};
+
+#endif
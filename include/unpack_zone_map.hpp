@@ -0,0 +1,162 @@
+#ifndef UNPACK_ZONE_MAP
+#define UNPACK_ZONE_MAP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "unpack_query.hpp"
+#include "unpack_simd.hpp"
+#include "unpack_vector.hpp"
+
+// Rows summarized per zone. Equal to the query batch size, so that a query
+// can skip a whole batch on a single zone.
+constexpr std::size_t unpack_zone_rows = unpack_query_batch_rows;
+
+template <typename X>
+struct unpack_between {
+  X lo;
+  X hi;
+
+  bool operator()(const X& x) const {
+    return !(x < lo) && !(hi < x);
+  }
+};
+
+template <std::size_t N, typename T>
+class unpack_zone_map;
+
+// Keeps the rows of a batch whose column N lies in [lo, hi], skipping
+// batches whose zone shows no value in that range.
+template <std::size_t N, typename T>
+struct zone_predicate {
+  using value_type = typename std::tuple_element<N, T>::type;
+
+  const unpack_zone_map<N, T>* zones;
+  column_predicate<N, unpack_between<value_type>> range;
+
+  template <typename V>
+  std::size_t refine(const V& v, std::size_t first, std::size_t rows, std::uint32_t* sel,
+      std::size_t selected) const {
+    return range.refine(v, first, rows, sel, selected);
+  }
+
+  template <typename V>
+  bool skips(const V& v, std::size_t first) const {
+    return zones->excludes(first / unpack_zone_rows, v.size(), range.f.lo, range.f.hi);
+  }
+};
+
+// Per zone minimum and maximum of column N of a vector<unpack<T>>, for
+// skipping zones in range scans. The map is kept apart from the vector:
+// update folds in the rows appended since the last update, reading only
+// those, and rows changed in place must be reported with invalidate. A
+// zone is only used for skipping while the map covers all of its rows and
+// it is not invalidated.
+template <std::size_t N, typename T>
+class unpack_zone_map {
+  public:
+    using value_type = typename std::tuple_element<N, T>::type;
+
+  private:
+    std::vector<value_type> _min;
+    std::vector<value_type> _max;
+    std::vector<unsigned char> _stale;
+    std::size_t _rows;
+
+    template <typename Op>
+    static value_type reduce(const value_type* p, std::size_t n, value_type init, Op op) {
+      UNPACK_COLUMN_DISPATCH(simd_runtime_level(), reduce, p, n, init, op)
+    }
+
+    void summarize(const value_type* p, std::size_t zone, std::size_t first, std::size_t last,
+        bool fresh) {
+      value_type lo = fresh ? p[first] : _min[zone];
+      value_type hi = fresh ? p[first] : _max[zone];
+      _min[zone] = reduce(p + first, last - first, lo,
+          [](value_type a, value_type b) { return b < a ? b : a; });
+      _max[zone] = reduce(p + first, last - first, hi,
+          [](value_type a, value_type b) { return a < b ? b : a; });
+      _stale[zone] = 0;
+    }
+
+  public:
+    unpack_zone_map() : _rows(0) {}
+
+    explicit unpack_zone_map(const std::vector<unpack<T>>& v) : _rows(0) {
+      update(v);
+    }
+
+    // Rows of v covered by the map.
+    std::size_t rows() const {
+      return _rows;
+    }
+
+    std::size_t zones() const {
+      return _min.size();
+    }
+
+    // Marks the zones holding rows [first, last) as changed. They are
+    // summarized again by the next update.
+    void invalidate(std::size_t first, std::size_t last) {
+      last = std::min(last, _rows);
+      for (std::size_t zone = first / unpack_zone_rows; zone * unpack_zone_rows < last;
+          zone++) {
+        _stale[zone] = 1;
+      }
+    }
+
+    // Brings the map up to date with v: rows past rows() are folded into
+    // their zones and invalidated zones are summarized again. If v shrank,
+    // zones past its end are dropped.
+    void update(const std::vector<unpack<T>>& v) {
+      const value_type* p = v.template data<N>();
+      std::size_t zones = (v.size() + unpack_zone_rows - 1) / unpack_zone_rows;
+      if (v.size() < _rows) {
+        _rows = v.size();
+        if (_rows % unpack_zone_rows) {
+          _stale[_rows / unpack_zone_rows] = 1;
+        }
+      }
+      _min.resize(zones);
+      _max.resize(zones);
+      _stale.resize(zones, 1);
+      for (std::size_t zone = 0; zone < zones; zone++) {
+        std::size_t first = zone * unpack_zone_rows;
+        std::size_t last = std::min(first + unpack_zone_rows, v.size());
+        if (_stale[zone]) {
+          summarize(p, zone, first, last, true);
+        } else if (last > _rows) {
+          summarize(p, zone, _rows, last, false);
+        }
+      }
+      _rows = v.size();
+    }
+
+    // Whether zone certainly holds no value in [lo, hi] among the `size`
+    // rows of the vector.
+    bool excludes(std::size_t zone, std::size_t size, const value_type& lo,
+        const value_type& hi) const {
+      if (zone >= _min.size() || _stale[zone]
+          || std::min(size, (zone + 1) * unpack_zone_rows) > _rows) {
+        return false;
+      }
+      return _max[zone] < lo || hi < _min[zone];
+    }
+
+    // Query predicate lo <= column N <= hi that skips excluded zones, e.g.
+    // query(v).where(zones.between(t0, t1)). The map must outlive the query.
+    zone_predicate<N, T> between(const value_type& lo, const value_type& hi) const {
+      return zone_predicate<N, T>{ this, { unpack_between<value_type>{ lo, hi } } };
+    }
+};
+
+// Builds the zone map of column N of v.
+template <std::size_t N, typename T>
+unpack_zone_map<N, T> zone_map(const std::vector<unpack<T>>& v) {
+  return unpack_zone_map<N, T>(v);
+}
+
+#endif
@@ -2,8 +2,37 @@
 #include <vector>
 #include <type_traits>
 #include <utility>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <sstream>
+#include <algorithm>
+#include <numeric>
+#if __cplusplus >= 201703L
+#include <execution>
+#endif
 
 #include "unpack.hpp"
+#include "unpack_arrow.hpp"
+#include "unpack_parallel.hpp"
+#include "unpack_kernels.hpp"
+#include "unpack_query.hpp"
+#include "unpack_group_by.hpp"
+#include "unpack_join.hpp"
+#include "unpack_zone_map.hpp"
+#include "unpack_search_index.hpp"
+#include "unpack_prefetch.hpp"
+#include "unpack_small_vector.hpp"
+#include "unpack_array.hpp"
+#include "unpack_deque.hpp"
+#include "unpack_mapped_vector.hpp"
+#include "unpack_concurrent_vector.hpp"
+#include "unpack_versioned_vector.hpp"
+#include "unpack_circular_buffer.hpp"
+#include "unpack_slot_map.hpp"
+#include "unpack_archetype.hpp"
+#include "unpack_matrix.hpp"
 #include "gtest/gtest.h"
 
 using std::vector;
@@ -783,10 +812,10 @@ TEST_F(UnpackTest, EmplaceBackCorrect) {
   auto ref = _v0.emplace_back(6, 7);
   ASSERT_EQ(std::get<0>(ref), 6);
   ASSERT_EQ(std::get<1>(ref), 7);
-  ref = _v0.emplace_back(0, 10000);
+  auto next = _v0.emplace_back(0, 10000);
   ASSERT_EQ(_v0.size(), 3);
-  ASSERT_EQ(std::get<0>(ref), 0);
-  ASSERT_EQ(std::get<1>(ref), 10000);
+  ASSERT_EQ(std::get<0>(next), 0);
+  ASSERT_EQ(std::get<1>(next), 10000);
 }
 
 TEST_F(UnpackTest, EraseRemovesElementReturnIterToNext) {
@@ -823,6 +852,967 @@ TEST_F(UnpackTest, EraseRangeRemovesAllElemsInRange) {
   ASSERT_TRUE(pos == _v0.end());
 }
 
+TEST_F(UnpackTest, ArrowFileRoundTrip) {
+  _v0 = { _e0, _e1, _e2, _e3, _e4 };
+  std::string path = ::testing::TempDir() + "unpack_arrow_test.arrow";
+  write_arrow_file(_v0, path, { "i", "d" });
+  arrow_reader reader(path);
+  ASSERT_EQ(reader.fields().size(), 2);
+  ASSERT_EQ(reader.fields()[1].name, "d");
+  ASSERT_EQ(reader.num_rows(), 5);
+  auto col = reader.column<double>(0, 1);
+  ASSERT_EQ(col.size(), 5);
+  ASSERT_EQ(col[2], 84.8);
+  _v1.assign(500, _e0);
+  reader.read(_v1);
+  ASSERT_EQ(_v1.size(), 505);
+  ASSERT_EQ(_v1[500], _e0);
+  ASSERT_EQ(_v1[504], _e4);
+  std::remove(path.c_str());
+}
+
+TEST_F(UnpackTest, ArrowStreamRoundTripWithStrings) {
+  vector<unpack<tuple<std::string, long long>>> v = {
+    tuple<std::string, long long>("", 1),
+    tuple<std::string, long long>("arrow", -2),
+    tuple<std::string, long long>("unpack", 3)
+  };
+  std::ostringstream os;
+  write_arrow_stream(v, os);
+  std::string bytes = os.str();
+  arrow_reader reader(bytes.data(), bytes.size());
+  auto strings = reader.column<std::string>(0, 0);
+  ASSERT_EQ(strings[1], "arrow");
+  ASSERT_EQ(strings.length(0), 0);
+  vector<unpack<tuple<std::string, long long>>> w;
+  reader.read(w);
+  ASSERT_EQ(v, w);
+}
+
+TEST_F(UnpackTest, ArrowColumnTypeMismatchThrows) {
+  _v0 = { _e0, _e1 };
+  std::ostringstream os;
+  write_arrow_stream(_v0, os);
+  std::string bytes = os.str();
+  arrow_reader reader(bytes.data(), bytes.size());
+  ASSERT_THROW(reader.column<float>(0, 1), std::invalid_argument);
+  vector<unpack<tuple<int>>> v;
+  ASSERT_THROW(reader.read(v), std::invalid_argument);
+}
+
+TEST_F(UnpackTest, ParallelForEachVisitsEveryRowOnce) {
+  vector<unpack<tuple<char, int, double>>> v(100003);
+  parallel_for_each(v, [](auto&& row) {
+    std::get<0>(row) += 1;
+    std::get<1>(row) += 2;
+    std::get<2>(row) += 3;
+  }, 4);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(v[i], (tuple<char, int, double>(1, 2, 3)));
+  }
+}
+
+TEST_F(UnpackTest, ParallelForEachRowRangeSumsIndices) {
+  _v0.resize(50000);
+  for (std::size_t i = 0; i < _v0.size(); i++) {
+    std::get<0>(_v0[i]) = static_cast<int>(i);
+  }
+  std::atomic<long long> sum(0);
+  parallel_for_each_row_range(_v0, [&sum](auto first, auto last) {
+    long long local = 0;
+    for (auto it = first; it != last; ++it) {
+      local += std::get<0>(*it);
+    }
+    sum += local;
+  }, 3);
+  ASSERT_EQ(sum, 50000ll * 49999 / 2);
+}
+
+TEST_F(UnpackTest, CacheAlignedPartitionNeverSharesLinesBetweenChunks) {
+  vector<unpack<tuple<char, short, double, std::array<char, 3>>>> v(10007);
+  auto layouts = column_layouts(v);
+  auto partition = cache_aligned_partition(v, 8);
+  ASSERT_EQ(partition.chunks.size(), 8);
+  std::vector<int> owner(v.size(), -1);
+  for (std::size_t c = 0; c < partition.chunks.size(); c++) {
+    for (auto i = partition.chunks[c].first; i < partition.chunks[c].second; i++) {
+      owner[i] = c;
+    }
+  }
+  for (auto& seam : partition.seams) {
+    for (auto i = seam.first; i < seam.second; i++) {
+      ASSERT_EQ(owner[i], -1);
+      owner[i] = -2;
+    }
+  }
+  for (auto& layout : layouts) {
+    for (std::size_t i = 1; i < v.size(); i++) {
+      auto prev_line = (layout.base + i * layout.element_size - 1) / unpack_cache_line_size;
+      auto line = (layout.base + i * layout.element_size) / unpack_cache_line_size;
+      ASSERT_NE(owner[i], -1);
+      if (owner[i] >= 0 && owner[i - 1] >= 0 && owner[i] != owner[i - 1]) {
+        ASSERT_NE(prev_line, line);
+      }
+    }
+  }
+}
+
+TEST_F(UnpackTest, ParallelForEachColumnVisitsEveryField) {
+  vector<unpack<tuple<char, int, double, long long>>> v(30011);
+  parallel_for_each_column(v, [](auto& field) { field += 1; }, 4);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(v[i], (tuple<char, int, double, long long>(1, 1, 1, 1)));
+  }
+  std::atomic<int> columns(0);
+  parallel_for_each_column_range(v, [&columns](auto first, auto last) {
+    columns++;
+    ASSERT_EQ(last - first, 30011);
+  }, 3);
+  ASSERT_EQ(columns, 4);
+}
+
+TEST_F(UnpackTest, ColumnGroupsMergeSmallColumns) {
+  std::size_t big = 4 * unpack_column_task_bytes;
+  auto groups = column_groups({ big, big, 1, 1, big }, 8);
+  ASSERT_EQ(groups.size(), 3);
+  ASSERT_EQ(groups[0], (std::pair<std::size_t, std::size_t>(0, 1)));
+  ASSERT_EQ(groups[1], (std::pair<std::size_t, std::size_t>(1, 2)));
+  ASSERT_EQ(groups[2], (std::pair<std::size_t, std::size_t>(2, 5)));
+  groups = column_groups({ big, big, big, big }, 2);
+  ASSERT_EQ(groups.size(), 2);
+  ASSERT_EQ(groups[1], (std::pair<std::size_t, std::size_t>(2, 4)));
+  ASSERT_EQ(column_groups({ 1, 1, 1 }, 4).size(), 1);
+}
+
+TEST_F(UnpackTest, IteratorsAreRandomAccess) {
+  using traits = std::iterator_traits<decltype(_v0)::iterator>;
+  using const_traits = std::iterator_traits<decltype(_v0)::const_iterator>;
+  ASSERT_TRUE((std::is_same<traits::iterator_category, std::random_access_iterator_tag>::value));
+  ASSERT_TRUE((std::is_same<const_traits::iterator_category,
+        std::random_access_iterator_tag>::value));
+  ASSERT_TRUE((std::is_same<traits::value_type, tuple<int, double>>::value));
+  _v0 = { _e0, _e1, _e2, _e3, _e4 };
+  const auto it = _v0.begin();
+  ASSERT_EQ(it[2], _e2);
+  ASSERT_EQ(*(2 + it), _e2);
+  ASSERT_EQ(*it.operator->().operator->(), _e0);
+  std::sort(_v0.begin(), _v0.end());
+  ASSERT_EQ(_v0, (vector<unpack<tuple<int, double>>>{ _e0, _e3, _e4, _e2, _e1 }));
+}
+
+#if __cplusplus >= 201703L
+TEST_F(UnpackTest, ExecutionPolicyAlgorithms) {
+  vector<unpack<tuple<int, double>>> v(20000);
+  std::for_each(std::execution::par_unseq, v.begin(), v.end(), [](auto&& row) {
+    std::get<1>(row) = 0.5;
+  });
+  for (std::size_t i = 0; i < v.size(); i++) {
+    std::get<0>(v[i]) = static_cast<int>((i * 7919) % v.size());
+  }
+  double sum = std::transform_reduce(std::execution::par, v.begin(), v.end(), 0.0,
+      std::plus<double>(), [](const auto& row) {
+    return std::get<0>(row) * std::get<1>(row);
+  });
+  ASSERT_EQ(sum, 0.5 * 20000 * 19999 / 2);
+  std::sort(std::execution::par, v.begin(), v.end(), [](const auto& a, const auto& b) {
+    return std::get<0>(a) < std::get<0>(b);
+  });
+  for (std::size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(v[i], (tuple<int, double>(i, 0.5)));
+  }
+}
+#endif
+
+TEST_F(UnpackTest, ColumnKernelsMatchScalarResultsAtEveryLevel) {
+  for (auto level : { simd_level::scalar, simd_level::sse2, simd_level::avx2, simd_level::avx512 }) {
+    vector<unpack<tuple<char, int, double, long double>>> v(1003);
+    column_fill<0>(v, 'x', level);
+    column_fill<3>(v, 0.25l, level);
+    for (std::size_t i = 0; i < v.size(); i++) {
+      std::get<1>(v[i]) = static_cast<int>(i) - 500;
+      std::get<2>(v[i]) = static_cast<double>(i);
+    }
+    column_transform<1>(v, [](int x) { return x > 0 ? 1 - x : -x - 1; }, level);
+    column_transform<2>(v, [](double x) { return x * 2; }, level);
+    for (std::size_t i = 0; i < v.size(); i++) {
+      int x = static_cast<int>(i) - 500;
+      ASSERT_EQ(v[i], (tuple<char, int, double, long double>(
+              'x', x > 0 ? 1 - x : -x - 1, 2.0 * i, 0.25l)));
+    }
+    ASSERT_EQ(column_reduce<2>(v, 1.0, std::plus<double>(), level), 1.0 + 1003.0 * 1002);
+    ASSERT_EQ(column_reduce<1>(v, 0, [](int a, int b) { return std::max(a, b); }, level), 499);
+    ASSERT_EQ(column_reduce<3>(v, 0.0l, std::plus<long double>(), level), 0.25l * 1003);
+    auto dot = column_transform_reduce<2, 3>(v, 0.0, std::plus<double>(),
+        [](double a, long double b) { return static_cast<double>(a * b); }, level);
+    ASSERT_EQ(dot, 0.5 * 1003 * 1002 / 2);
+    vector<unpack<tuple<char, int, double, long double>>> empty;
+    ASSERT_EQ(column_reduce<2>(empty, 3.0, std::plus<double>(), level), 3.0);
+  }
+}
+
+TEST_F(UnpackTest, ColumnExpressionsEvaluateInOnePass) {
+  vector<unpack<tuple<double, double, int, float>>> v(1001);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    v[i] = tuple<double, double, int, float>(0, i, 2, 0.5f);
+  }
+  v.col<0>() = v.col<1>() * v.col<2>() + v.col<3>();
+  ASSERT_EQ(std::get<0>(v[10]), 20.5);
+  v.col<0>() -= 2 * v.col<1>();
+  v.col<0>() *= 4;
+  v.col<3>() = -v.col<2>() / 4.0f;
+  const auto& cv = v;
+  v.col<1>() = cv.col<0>();
+  for (std::size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(v[i], (tuple<double, double, int, float>(2, 2, 2, -0.5f)));
+  }
+  vector<unpack<tuple<double>>> shorter(10);
+  ASSERT_THROW(v.col<0>() = shorter.col<0>() + 1, std::length_error);
+}
+
+TEST_F(UnpackTest, ParallelAssignMatchesSerialAssign) {
+  vector<unpack<tuple<char, double, double>>> v(100003);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    std::get<1>(v[i]) = static_cast<double>(i);
+  }
+  parallel_assign(v.col<2>(), v.col<1>() * v.col<1>() - 1.0, 4);
+  parallel_assign(v.col<0>(), v.col<0>() + 'a', 3);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(v[i], (tuple<char, double, double>('a', i, 1.0 * i * i - 1)));
+  }
+}
+
+TEST_F(UnpackTest, QueryFiltersAndAggregatesSelectedRows) {
+  vector<unpack<tuple<int, double, char>>> v(10000);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    v[i] = tuple<int, double, char>(i, i * 0.5, i % 3 ? 'a' : 'b');
+  }
+  auto all = query(v);
+  ASSERT_EQ(all.count(), 10000);
+  ASSERT_EQ(all.sum<0>(), 10000ll * 9999 / 2);
+  ASSERT_EQ(all.max<1>(), 4999.5);
+  auto q = all.where<2>([](char c) { return c == 'b'; }).where<0>([](int x) { return x >= 5000; });
+  ASSERT_EQ(q.count(), 1667);
+  ASSERT_EQ(q.min<0>(), 5001);
+  ASSERT_EQ(q.max<0>(), 9999);
+  ASSERT_EQ(q.mean<0>(), 7500.0);
+  auto rows = q.selection();
+  ASSERT_EQ(rows.size(), 1667);
+  ASSERT_EQ(rows.front(), 5001);
+  ASSERT_EQ(rows.back(), 9999);
+  auto none = q.where<1>([](double x) { return x < 0; });
+  ASSERT_EQ(none.count(), 0);
+  ASSERT_THROW(none.min<0>(), std::domain_error);
+}
+
+TEST_F(UnpackTest, QueryProjectsOnlyRequestedColumns) {
+  _v0 = { _e0, _e1, _e2, _e3, _e4 };
+  auto projected = query(_v0).where<1>([](double x) { return x > 80; }).project<1, 0>();
+  ASSERT_EQ(projected.size(), 3);
+  ASSERT_EQ(projected[0], (tuple<double, int>(92.2, 123)));
+  ASSERT_EQ(projected[2], (tuple<double, int>(98.4, 8)));
+}
+
+TEST_F(UnpackTest, GroupByAggregatesEachKey) {
+  vector<unpack<tuple<int, double, char>>> v;
+  for (int i = 0; i < 10000; i++) {
+    v.push_back(tuple<int, double, char>(i % 7, i, 'a' + i % 2));
+  }
+  auto by_key = group_by<0>(v).aggregate<1, 1, 1, 2>(group_sum(), group_min(), group_count(),
+      group_max());
+  ASSERT_EQ(by_key.size(), 7);
+  for (int k = 0; k < 7; k++) {
+    double sum = 0;
+    std::size_t count = 0;
+    for (int i = k; i < 10000; i += 7) {
+      sum += i;
+      count++;
+    }
+    ASSERT_EQ(by_key[k], (tuple<int, double, double, std::size_t, char>(k, sum, k, count, 'b')));
+  }
+  auto by_pair = group_by<0, 2>(v).aggregate<1>(group_mean());
+  ASSERT_EQ(by_pair.size(), 14);
+  ASSERT_EQ(by_pair[0], (tuple<int, char, double>(0, 'a', (0 + 9996) / 2.0)));
+}
+
+TEST_F(UnpackTest, ParallelGroupByMatchesSerialGroupBy) {
+  vector<unpack<tuple<long long, int>>> v(200000);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    v[i] = tuple<long long, int>((i * 2654435761u) % 5003, 1);
+  }
+  auto serial = group_by<0>(v).aggregate<1>(group_sum());
+  auto parallel = group_by<0>(v, 4).aggregate<1>(group_sum());
+  ASSERT_EQ(serial.size(), 5003);
+  std::sort(serial.begin(), serial.end());
+  std::sort(parallel.begin(), parallel.end());
+  ASSERT_EQ(serial, parallel);
+  long long total = 0;
+  for (std::size_t g = 0; g < parallel.size(); g++) {
+    total += std::get<1>(parallel[g]);
+  }
+  ASSERT_EQ(total, 200000);
+}
+
+TEST_F(UnpackTest, HashJoinMatchesNestedLoopJoin) {
+  vector<unpack<tuple<int, double>>> orders;
+  for (int i = 0; i < 3000; i++) {
+    orders.push_back(tuple<int, double>(i % 113, i));
+  }
+  vector<unpack<tuple<char, int>>> customers;
+  for (int i = 0; i < 200; i += 2) {
+    customers.push_back(tuple<char, int>('a' + i % 26, i));
+  }
+  std::vector<std::pair<std::size_t, std::size_t>> expected;
+  for (std::size_t l = 0; l < orders.size(); l++) {
+    for (std::size_t r = 0; r < customers.size(); r++) {
+      if (std::get<0>(orders[l]) == std::get<1>(customers[r])) {
+        expected.emplace_back(l, r);
+      }
+    }
+  }
+  for (std::size_t threads : { 1, 3 }) {
+    auto j = hash_join<0, 1>(orders, customers, threads);
+    ASSERT_EQ(j.size(), expected.size());
+    std::vector<std::pair<std::size_t, std::size_t>> pairs;
+    for (std::size_t i = 0; i < j.size(); i++) {
+      pairs.emplace_back(j.left_rows()[i], j.right_rows()[i]);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    ASSERT_EQ(pairs, expected);
+  }
+}
+
+TEST_F(UnpackTest, HashJoinMaterializesRequestedColumns) {
+  vector<unpack<tuple<int, double>>> left;
+  left.push_back(tuple<int, double>(1, 1.5));
+  left.push_back(tuple<int, double>(2, 2.5));
+  left.push_back(tuple<int, double>(2, 3.5));
+  vector<unpack<tuple<int, char>>> right;
+  right.push_back(tuple<int, char>(2, 'x'));
+  right.push_back(tuple<int, char>(3, 'y'));
+  auto j = hash_join<0, 0>(left, right);
+  ASSERT_EQ(j.size(), 2);
+  auto l = j.left<1>();
+  auto r = j.right<1, 0>();
+  ASSERT_EQ(l.size(), 2);
+  ASSERT_EQ(std::get<0>(l[0]) + std::get<0>(l[1]), 6.0);
+  ASSERT_EQ(r[0], (tuple<char, int>('x', 2)));
+  ASSERT_EQ(r[1], (tuple<char, int>('x', 2)));
+}
+
+TEST_F(UnpackTest, ZoneMapSkipsBlocksOutsideRange) {
+  vector<unpack<tuple<long long, int>>> events;
+  for (long long t = 0; t < 10 * 4096; t++) {
+    events.push_back(tuple<long long, int>(t, 1));
+  }
+  auto zones = zone_map<0>(events);
+  ASSERT_EQ(zones.zones(), 10);
+  auto q = query(events).where(zones.between(5000, 9000));
+  std::size_t batches = 0;
+  q.for_each_batch([&batches](std::size_t, const std::uint32_t*, std::size_t, std::size_t) {
+    batches++;
+  });
+  ASSERT_EQ(batches, 2);
+  ASSERT_EQ(q.count(), 4001);
+  ASSERT_EQ(q.sum<1>(), 4001);
+}
+
+TEST_F(UnpackTest, ZoneMapFollowsAppendsAndInvalidation) {
+  vector<unpack<tuple<int, char>>> v;
+  for (int i = 0; i < 5000; i++) {
+    v.push_back(tuple<int, char>(i, 'a'));
+  }
+  auto zones = zone_map<0>(v);
+  auto in_range = [&]() {
+    return query(v).where(zones.between(-10, -1)).count();
+  };
+  ASSERT_EQ(in_range(), 0);
+  v.push_back(tuple<int, char>(-5, 'b'));
+  ASSERT_EQ(in_range(), 1);
+  zones.update(v);
+  ASSERT_EQ(zones.rows(), 5001);
+  ASSERT_EQ(in_range(), 1);
+  std::get<0>(v[10]) = -3;
+  zones.invalidate(10, 11);
+  ASSERT_EQ(in_range(), 2);
+  zones.update(v);
+  ASSERT_EQ(in_range(), 2);
+  ASSERT_FALSE(zones.excludes(0, v.size(), -10, -1));
+  ASSERT_TRUE(zones.excludes(1, v.size(), 6000, 7000));
+}
+
+TEST_F(UnpackTest, SearchIndexMatchesLowerBound) {
+  for (std::size_t n : { 0, 1, 2, 7, 1000, 4097 }) {
+    vector<unpack<tuple<int, char>>> v;
+    for (std::size_t i = 0; i < n; i++) {
+      v.push_back(tuple<int, char>(static_cast<int>(i / 3 * 2), 'a'));
+    }
+    auto index = search_index<0>(v);
+    ASSERT_EQ(index.size(), n);
+    std::vector<int> keys;
+    for (int key = -2; key < static_cast<int>(n) + 2; key++) {
+      keys.push_back(key);
+    }
+    auto rows = index.lower_bound(keys);
+    for (std::size_t j = 0; j < keys.size(); j++) {
+      auto expected = std::lower_bound(v.begin<0>(), v.end<0>(), keys[j]) - v.begin<0>();
+      ASSERT_EQ(index.lower_bound(keys[j]), expected);
+      ASSERT_EQ(rows[j], expected);
+      bool found = expected < static_cast<long>(n) && std::get<0>(v[expected]) == keys[j];
+      ASSERT_EQ(index.find(keys[j]), found ? expected : n);
+    }
+  }
+}
+
+TEST_F(UnpackTest, SearchIndexRejectsUnsortedColumn) {
+  vector<unpack<tuple<int, double>>> v;
+  v.push_back(tuple<int, double>(2, 0.5));
+  v.push_back(tuple<int, double>(1, 0.25));
+  ASSERT_THROW(search_index<0>(v), std::invalid_argument);
+  ASSERT_EQ(search_index<1>(vector<unpack<tuple<int, double>>>(3)).size(), 3);
+}
+
+TEST_F(UnpackTest, ForEachPrefetchedVisitsRowsInOrder) {
+  vector<unpack<tuple<char, double, int>>> v(1000);
+  for (std::size_t distance : { 0, 1, 5, 5000 }) {
+    int next = 0;
+    for_each_prefetched(v, [&next](auto&& row) { std::get<2>(row) = next++; }, distance);
+    ASSERT_EQ(next, 1000);
+    for (int i = 0; i < 1000; i++) {
+      ASSERT_EQ(std::get<2>(v[i]), i);
+    }
+    column_fill<2>(v, -1);
+  }
+  ASSERT_EQ(unpack_prefetch_distance(v), unpack_prefetch_bytes / 13);
+}
+
+TEST_F(UnpackTest, LargeBulkWritesStreamEveryColumn) {
+  std::size_t n = unpack_stream_bytes / 8 + 3;
+  vector<unpack<tuple<char, double, std::string, std::array<char, 3>>>> v;
+  v.assign(n, tuple<char, double, std::string, std::array<char, 3>>('x', 1.5, "s", {{ 'a', 'b', 'c' }}));
+  ASSERT_EQ(v.size(), n);
+  ASSERT_EQ(std::count(v.begin<0>(), v.end<0>(), 'x'), n);
+  ASSERT_EQ(std::count(v.begin<1>(), v.end<1>(), 1.5), n);
+  ASSERT_EQ(v[n - 1], (tuple<char, double, std::string, std::array<char, 3>>('x', 1.5, "s",
+          {{ 'a', 'b', 'c' }})));
+  auto copy = v;
+  ASSERT_EQ(copy, v);
+  copy = copy;
+  ASSERT_EQ(copy, v);
+  v.resize(2 * n, tuple<char, double, std::string, std::array<char, 3>>('y', 2.5, "t", {{ 'd' }}));
+  ASSERT_EQ(std::count(v.begin<1>(), v.end<1>(), 2.5), n);
+  ASSERT_EQ(std::get<2>(v[2 * n - 1]), "t");
+}
+
+TEST_F(UnpackTest, ResizeValueInitializesReusedStorage) {
+  for (std::size_t n : { std::size_t(100), unpack_stream_bytes / 8 + 1 }) {
+    vector<unpack<tuple<int, double, std::array<int, 2>>>> v;
+    v.assign(n, tuple<int, double, std::array<int, 2>>(7, 7.5, {{ 7, 7 }}));
+    v.resize(0);
+    v.resize(n);
+    ASSERT_EQ(std::count(v.begin<0>(), v.end<0>(), 0), n);
+    ASSERT_EQ(std::count(v.begin<1>(), v.end<1>(), 0.0), n);
+    ASSERT_EQ(std::get<2>(v[n / 2]), (std::array<int, 2>{{ 0, 0 }}));
+  }
+}
+
+TEST_F(UnpackTest, DefaultInitResizeOnlySetsSize) {
+  vector<unpack<tuple<int, std::string, double>>> v(1000, unpack_default_init);
+  ASSERT_EQ(v.size(), 1000);
+  ASSERT_EQ(std::count(v.begin<1>(), v.end<1>(), std::string()), 1000);
+  column_fill<0>(v, 3);
+  v.resize(5000, unpack_default_init);
+  ASSERT_EQ(v.size(), 5000);
+  ASSERT_EQ(std::count(v.begin<0>(), v.begin<0>() + 1000, 3), 1000);
+  v.resize(10, unpack_default_init);
+  ASSERT_EQ(v.size(), 10);
+  ASSERT_EQ(std::get<0>(v[9]), 3);
+}
+
+TEST_F(UnpackTest, SmallVectorStaysInlineUntilFull) {
+  small_vector<unpack<tuple<int, std::string>>, 4> v;
+  for (int i = 0; i < 4; i++) {
+    v.push_back(tuple<int, std::string>(i, std::to_string(i)));
+  }
+  ASSERT_TRUE(v.is_inline());
+  ASSERT_EQ(v.capacity(), 4);
+  auto copy = v;
+  v.emplace_back(4, "4");
+  ASSERT_FALSE(v.is_inline());
+  ASSERT_EQ(v.size(), 5);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(v[i], (tuple<int, std::string>(i, std::to_string(i))));
+  }
+  ASSERT_TRUE(copy.is_inline());
+  ASSERT_EQ(copy.size(), 4);
+  auto moved = std::move(v);
+  ASSERT_EQ(moved.size(), 5);
+  ASSERT_EQ(std::get<1>(moved.back()), "4");
+  ASSERT_EQ(v.size(), 0);
+  ASSERT_TRUE(v.is_inline());
+}
+
+TEST_F(UnpackTest, SmallVectorSupportsRowAndColumnAccess) {
+  small_vector<unpack<tuple<int, double>>, 8> v = {
+    tuple<int, double>(3, 0.5), tuple<int, double>(1, 1.5), tuple<int, double>(2, 2.5)
+  };
+  std::sort(v.begin(), v.end());
+  ASSERT_EQ(v.front(), (tuple<int, double>(1, 1.5)));
+  ASSERT_EQ(std::accumulate(v.begin<1>(), v.end<1>(), 0.0), 4.5);
+  v.insert(v.cbegin() + 1, tuple<int, double>(7, 7.5));
+  ASSERT_EQ(std::get<0>(v[1]), 7);
+  v.erase(v.cbegin());
+  ASSERT_EQ(v.size(), 3);
+  ASSERT_EQ(v.data<0>()[0], 7);
+  ASSERT_THROW(v.at(3), std::out_of_range);
+  v.resize(20);
+  ASSERT_EQ(v[19], (tuple<int, double>(0, 0.0)));
+  small_vector<unpack<tuple<int, double>>, 8> w;
+  w.swap(v);
+  ASSERT_EQ(w.size(), 20);
+  ASSERT_TRUE(v.empty());
+  ASSERT_NE(v, w);
+}
+
+TEST_F(UnpackTest, FixedArrayHasConstantSize) {
+  using points = std::array<unpack<tuple<float, int>>, 8>;
+  static_assert(points::size() == 8, "array size must be a constant expression");
+  points a{};
+  ASSERT_EQ(a.back(), (tuple<float, int>(0.0f, 0)));
+  a.fill(tuple<float, int>(1.5f, 2));
+  float* xs = a.data<0>();
+  for (std::size_t i = 0; i < a.size(); i++) {
+    xs[i] *= i;
+  }
+  ASSERT_EQ(std::accumulate(a.begin<0>(), a.end<0>(), 0.0f), 42.0f);
+  a.col<1>() = a.col<1>() * 3;
+  ASSERT_EQ(a[7], (tuple<float, int>(10.5f, 6)));
+  ASSERT_THROW(a.at(8), std::out_of_range);
+}
+
+TEST_F(UnpackTest, FixedArraySortsRows) {
+  std::array<unpack<tuple<int, char>>, 4> a;
+  for (int i = 0; i < 4; i++) {
+    a[i] = tuple<int, char>(4 - i, 'a' + i);
+  }
+  std::sort(a.begin(), a.end());
+  ASSERT_EQ(a.front(), (tuple<int, char>(1, 'd')));
+  ASSERT_TRUE(std::is_sorted(a.cbegin(), a.cend()));
+  std::array<unpack<tuple<int, char>>, 4> b = a;
+  ASSERT_EQ(a, b);
+  std::get<1>(b[0]) = 'z';
+  swap(a, b);
+  ASSERT_EQ(std::get<1>(a[0]), 'z');
+  ASSERT_NE(a, b);
+}
+
+TEST_F(UnpackTest, DequeGrowsAtBothEndsWithoutMoving) {
+  std::deque<unpack<tuple<int, std::string>>> d;
+  d.push_back(tuple<int, std::string>(0, "0"));
+  const int* first = &std::get<0>(d.front());
+  for (int i = 1; i <= 3000; i++) {
+    d.push_back(tuple<int, std::string>(i, std::to_string(i)));
+    d.emplace_front(-i, std::to_string(-i));
+  }
+  ASSERT_EQ(d.size(), 6001);
+  ASSERT_EQ(first, &std::get<0>(d[3000]));
+  for (int i = 0; i < 6001; i++) {
+    ASSERT_EQ(d[i], (tuple<int, std::string>(i - 3000, std::to_string(i - 3000))));
+  }
+  ASSERT_EQ(std::accumulate(d.begin<0>(), d.end<0>(), 0), 0);
+  while (d.size() > 10) {
+    d.pop_front();
+  }
+  ASSERT_EQ(std::get<0>(d.front()), 2991);
+  ASSERT_LE(d.segments(), 2);
+  ASSERT_THROW(d.at(10), std::out_of_range);
+  d.clear();
+  ASSERT_EQ(d.segments(), 0);
+}
+
+TEST_F(UnpackTest, DequeSupportsRowAlgorithms) {
+  std::deque<unpack<tuple<int, double>>> d(2500);
+  for (std::size_t i = 0; i < d.size(); i++) {
+    d[i] = tuple<int, double>(2500 - i, 0.5 * i);
+  }
+  std::sort(d.begin(), d.end());
+  ASSERT_TRUE(std::is_sorted(d.cbegin(), d.cend()));
+  ASSERT_EQ(d.front(), (tuple<int, double>(1, 1249.5)));
+  std::deque<unpack<tuple<int, double>>> copy = d;
+  ASSERT_EQ(copy, d);
+  copy.resize(3000, tuple<int, double>(7, 7.0));
+  ASSERT_EQ(copy.back(), (tuple<int, double>(7, 7.0)));
+  copy.resize(100);
+  ASSERT_EQ(copy.size(), 100);
+  ASSERT_NE(copy, d);
+  swap(copy, d);
+  ASSERT_EQ(d.size(), 100);
+}
+
+TEST_F(UnpackTest, MappedVectorGrowsInPlace) {
+  mapped_vector<unpack<tuple<int, double>>> v(1 << 20);
+  ASSERT_EQ(v.max_size(), 1 << 20);
+  v.push_back(tuple<int, double>(0, 0.0));
+  const int* ints = v.data<0>();
+  const double* doubles = v.data<1>();
+  for (int i = 1; i < 100000; i++) {
+    v.emplace_back(i, 0.5 * i);
+  }
+  ASSERT_EQ(ints, v.data<0>());
+  ASSERT_EQ(doubles, v.data<1>());
+  ASSERT_EQ(v[99999], (tuple<int, double>(99999, 49999.5)));
+  ASSERT_EQ(std::accumulate(v.begin<0>(), v.end<0>(), 0L), 99999L * 100000 / 2);
+  v.resize(1 << 20);
+  ASSERT_EQ(v.back(), (tuple<int, double>(0, 0.0)));
+  ASSERT_THROW(v.push_back(tuple<int, double>(1, 1.0)), std::length_error);
+  v.resize(10);
+  v.shrink_to_fit();
+  ASSERT_LT(v.capacity(), 1 << 20);
+  v.resize(5000, tuple<int, double>(3, 1.5));
+  ASSERT_EQ(v[4999], (tuple<int, double>(3, 1.5)));
+  ASSERT_EQ(ints, v.data<0>());
+}
+
+TEST_F(UnpackTest, MappedVectorSupportsRowAlgorithms) {
+  mapped_vector<unpack<tuple<int, char>>> v;
+  for (int i = 0; i < 1000; i++) {
+    v.push_back(tuple<int, char>(1000 - i, 'a' + i % 26));
+  }
+  std::sort(v.begin(), v.end());
+  ASSERT_TRUE(std::is_sorted(v.cbegin(), v.cend()));
+  ASSERT_EQ(v.front(), (tuple<int, char>(1, 'a' + 999 % 26)));
+  mapped_vector<unpack<tuple<int, char>>> copy = v;
+  ASSERT_EQ(copy, v);
+  copy.col<0>() = copy.col<0>() * 2;
+  ASSERT_EQ(std::get<0>(copy.back()), 2000);
+  ASSERT_NE(copy, v);
+  swap(copy, v);
+  ASSERT_EQ(std::get<0>(v.back()), 2000);
+  ASSERT_THROW(v.at(1000), std::out_of_range);
+}
+
+TEST_F(UnpackTest, RemappedVectorKeepsRowsAcrossGrowth) {
+  mapped_vector<unpack<tuple<long, float>>, unpack_remapped_column> v;
+  ASSERT_EQ(v.capacity(), 0);
+  for (long i = 0; i < 200000; i++) {
+    v.push_back(tuple<long, float>(i, 0.25f * i));
+  }
+  ASSERT_GE(v.capacity(), 200000);
+  for (long i = 0; i < 200000; i += 997) {
+    ASSERT_EQ(v[i], (tuple<long, float>(i, 0.25f * i)));
+  }
+  v.resize(3);
+  v.shrink_to_fit();
+  ASSERT_LT(v.capacity(), 200000);
+  ASSERT_EQ(v.back(), (tuple<long, float>(2, 0.5f)));
+  v.clear();
+  v.shrink_to_fit();
+  ASSERT_EQ(v.capacity(), 0);
+  v.emplace_back(7L, 7.0f);
+  ASSERT_EQ(v.front(), (tuple<long, float>(7, 7.0f)));
+}
+
+TEST_F(UnpackTest, ConcurrentVectorPublishesWholeRows) {
+  concurrent_vector<unpack<tuple<int, long>>> v;
+  const int producers = 4;
+  const int rows = 20000;
+  std::atomic<bool> done(false);
+  std::atomic<bool> torn(false);
+  std::thread reader([&]() {
+    while (!done) {
+      std::size_t size = v.size();
+      for (std::size_t i = size > 64 ? size - 64 : 0; i < size; i++) {
+        if (std::get<1>(v[i]) != 3L * std::get<0>(v[i])) {
+          torn = true;
+        }
+      }
+    }
+  });
+  std::vector<std::thread> pool;
+  for (int p = 0; p < producers; p++) {
+    pool.emplace_back([&v, p, rows]() {
+      for (int i = 0; i < rows; i += 2) {
+        int id = p * rows + i;
+        if (i % 4) {
+          v.push_back(tuple<int, long>(id, 3L * id));
+          v.push_back(tuple<int, long>(id + 1, 3L * (id + 1)));
+        } else {
+          tuple<int, long> batch[] = { tuple<int, long>(id, 3L * id),
+            tuple<int, long>(id + 1, 3L * (id + 1)) };
+          v.append(batch, batch + 2);
+        }
+      }
+    });
+  }
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  done = true;
+  reader.join();
+  ASSERT_FALSE(torn);
+  ASSERT_EQ(v.size(), producers * rows);
+  std::vector<int> ids(v.begin<0>(), v.end<0>());
+  std::sort(ids.begin(), ids.end());
+  for (int i = 0; i < producers * rows; i++) {
+    ASSERT_EQ(ids[i], i);
+  }
+  long total = 0;
+  std::size_t chunks = 0;
+  v.for_each_chunk<1>([&](const long* data, std::size_t n) {
+    total = std::accumulate(data, data + n, total);
+    chunks++;
+  });
+  ASSERT_EQ(total, 3L * (producers * rows - 1) * producers * rows / 2);
+  ASSERT_GT(chunks, 1);
+  ASSERT_THROW(v.at(producers * rows), std::out_of_range);
+}
+
+TEST_F(UnpackTest, VersionedVectorSnapshotsAreImmutable) {
+  versioned_vector<unpack<tuple<int, double>>> v;
+  for (int i = 0; i < 5000; i++) {
+    v.push_back(tuple<int, double>(i, 0.5 * i));
+  }
+  ASSERT_EQ(v.snapshot().size(), 0);
+  v.commit();
+  {
+    auto before = v.snapshot();
+    v.set<0>(0, -1);
+    v.push_back(tuple<int, double>(5000, 2500.0));
+    v.commit();
+    auto after = v.snapshot();
+    ASSERT_EQ(before.size(), 5000);
+    ASSERT_EQ(before[0], (tuple<int, double>(0, 0.0)));
+    ASSERT_EQ(after.size(), 5001);
+    ASSERT_EQ(after[0], (tuple<int, double>(-1, 0.0)));
+    ASSERT_EQ(after.at(5000), (tuple<int, double>(5000, 2500.0)));
+    ASSERT_THROW(before.at(5000), std::out_of_range);
+    double total = 0;
+    before.for_each_chunk<1>([&total](const double* data, std::size_t n) {
+      total = std::accumulate(data, data + n, total);
+    });
+    ASSERT_EQ(total, 0.5 * 4999 * 5000 / 2);
+    ASSERT_GT(v.retired(), 0);
+  }
+  v.reclaim();
+  ASSERT_EQ(v.retired(), 0);
+}
+
+TEST_F(UnpackTest, VersionedVectorReadersSeeCommittedRows) {
+  versioned_vector<unpack<tuple<int, long>>> v;
+  std::atomic<bool> done(false);
+  std::atomic<bool> inconsistent(false);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; r++) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        auto s = v.snapshot();
+        if (s.size() % 100) {
+          inconsistent = true;
+        }
+        long generation = s.empty() ? 0 : std::get<1>(s[0]);
+        for (std::size_t i = 0; i < s.size(); i++) {
+          if (std::get<0>(s[i]) != static_cast<int>(i) || std::get<1>(s[i]) != generation) {
+            inconsistent = true;
+          }
+        }
+      }
+    });
+  }
+  for (long generation = 0; generation < 50; generation++) {
+    for (int i = 0; i < 100; i++) {
+      v.push_back(tuple<int, long>(static_cast<int>(v.size()), generation));
+    }
+    for (std::size_t i = 0; i < v.size(); i++) {
+      v.set<1>(i, generation);
+    }
+    v.commit();
+  }
+  done = true;
+  for (auto& thread : readers) {
+    thread.join();
+  }
+  ASSERT_FALSE(inconsistent);
+  ASSERT_EQ(v.snapshot().size(), 5000);
+}
+
+TEST_F(UnpackTest, CircularBufferSlidesWindow) {
+  circular_buffer<unpack<tuple<long, double>>> window(100);
+  for (long i = 0; i < 250; i++) {
+    window.push_back(tuple<long, double>(i, 0.5 * i));
+  }
+  ASSERT_TRUE(window.full());
+  ASSERT_EQ(window.front(), (tuple<long, double>(150, 75.0)));
+  ASSERT_EQ(window.back(), (tuple<long, double>(249, 124.5)));
+  std::size_t spans = 0;
+  window.for_each_chunk<0>([&spans](const long* data, std::size_t n) {
+    ASSERT_EQ(data[0], spans ? 200 : 150);
+    ASSERT_EQ(n, 50);
+    spans++;
+  });
+  ASSERT_EQ(spans, 2);
+  ASSERT_EQ(window.sum<0>(), (150L + 249L) * 100 / 2);
+  ASSERT_EQ(window.mean<1>(), 0.5 * (150 + 249) / 2);
+  ASSERT_EQ(window.min<0>(), 150);
+  ASSERT_EQ(window.max<1>(), 124.5);
+  ASSERT_EQ(std::accumulate(window.begin<0>(), window.end<0>(), 0L), window.sum<0>());
+  window.pop_front();
+  window.pop_back();
+  ASSERT_EQ(window.size(), 98);
+  ASSERT_EQ(window.min<0>(), 151);
+  window.push_front(tuple<long, double>(-1, -0.5));
+  ASSERT_EQ(window[0], (tuple<long, double>(-1, -0.5)));
+  ASSERT_EQ(window.at(98), (tuple<long, double>(248, 124.0)));
+  ASSERT_THROW(window.at(99), std::out_of_range);
+  ASSERT_THROW((circular_buffer<unpack<tuple<int>>>(0)), std::invalid_argument);
+}
+
+TEST_F(UnpackTest, CircularBufferSupportsRowAlgorithms) {
+  circular_buffer<unpack<tuple<int, char>>> ring(8);
+  for (int i = 0; i < 13; i++) {
+    ring.push_back(tuple<int, char>(i % 5, 'a' + i));
+  }
+  std::sort(ring.begin(), ring.end());
+  ASSERT_TRUE(std::is_sorted(ring.cbegin(), ring.cend()));
+  ASSERT_EQ(ring.front(), (tuple<int, char>(0, 'f')));
+  ASSERT_EQ(ring.end() - ring.begin(), 8);
+}
+
+TEST_F(UnpackTest, SlotMapHandlesSurviveErase) {
+  slot_map<unpack<tuple<int, float>>> entities;
+  std::vector<unpack_handle> handles;
+  for (int i = 0; i < 100; i++) {
+    handles.push_back(entities.insert(tuple<int, float>(i, 0.5f * i)));
+  }
+  for (int i = 0; i < 100; i += 3) {
+    ASSERT_TRUE(entities.erase(handles[i]));
+  }
+  ASSERT_FALSE(entities.erase(handles[0]));
+  ASSERT_EQ(entities.size(), 66);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(entities.contains(handles[i]), i % 3 != 0);
+    if (i % 3) {
+      ASSERT_EQ(entities[handles[i]], (tuple<int, float>(i, 0.5f * i)));
+    }
+  }
+  unpack_handle reused = entities.emplace(1000, 1.0f);
+  ASSERT_EQ(reused.slot, handles[99].slot);
+  ASSERT_NE(reused, handles[99]);
+  ASSERT_THROW(entities.at(handles[99]), std::out_of_range);
+  ASSERT_EQ(entities.handle(entities.index(reused)), reused);
+  ASSERT_EQ(std::get<0>(entities.at(reused)), 1000);
+  entities.clear();
+  ASSERT_TRUE(entities.empty());
+  ASSERT_FALSE(entities.contains(reused));
+}
+
+TEST_F(UnpackTest, SlotMapIteratesDenseColumns) {
+  slot_map<unpack<tuple<int, double>>> entities;
+  std::vector<unpack_handle> handles;
+  for (int i = 1; i <= 10; i++) {
+    handles.push_back(entities.insert(tuple<int, double>(i, i)));
+  }
+  entities.erase(handles[0]);
+  entities.erase(handles[4]);
+  ASSERT_EQ(entities.end<0>() - entities.begin<0>(), 8);
+  ASSERT_EQ(std::accumulate(entities.begin<0>(), entities.end<0>(), 0), 55 - 1 - 5);
+  for (auto row : entities) {
+    std::get<1>(row) *= 2;
+  }
+  ASSERT_EQ(std::get<1>(entities[handles[9]]), 20.0);
+  ASSERT_EQ(entities.rows().size(), 8);
+}
+
+TEST_F(UnpackTest, ArchetypeStoreMovesEntitiesBetweenTables) {
+  struct position { float x, y; };
+  struct velocity { float dx, dy; };
+  using moving = archetype<position, velocity>;
+  using still = archetype<position>;
+  archetype_store<still, moving> world;
+  unpack_handle a = world.create<moving>(position{ 0, 0 }, velocity{ 1, 2 });
+  unpack_handle b = world.create<still>(position{ 5, 5 });
+  unpack_handle c = world.create<moving>(position{ 1, 1 }, velocity{ 0, 1 });
+  ASSERT_TRUE(world.has<velocity>(a));
+  ASSERT_FALSE(world.has<velocity>(b));
+  world.remove<velocity>(a);
+  ASSERT_FALSE(world.has<velocity>(a));
+  ASSERT_EQ(world.get<position>(c).y, 1);
+  ASSERT_EQ(world.rows<still>().size(), 2);
+  ASSERT_EQ(world.rows<moving>().size(), 1);
+  world.add(b, velocity{ 3, 4 });
+  ASSERT_EQ(world.get<position>(b).x, 5);
+  ASSERT_EQ(world.get<velocity>(b).dy, 4);
+  ASSERT_THROW(world.get<velocity>(a), std::out_of_range);
+  world.destroy(c);
+  ASSERT_FALSE(world.contains(c));
+  ASSERT_THROW(world.get<position>(c), std::out_of_range);
+  ASSERT_EQ(world.size(), 2);
+  ASSERT_EQ(world.get<velocity>(b).dx, 3);
+  unpack_handle d = world.create<still>(position{ 7, 7 });
+  ASSERT_EQ(d.slot, c.slot);
+  ASSERT_NE(d, c);
+}
+
+TEST_F(UnpackTest, ArchetypeStoreQueriesMatchingColumns) {
+  using moving = archetype<float, int>;
+  using tagged = archetype<int, char>;
+  using still = archetype<float>;
+  archetype_store<moving, tagged, still> world;
+  for (int i = 0; i < 10; i++) {
+    world.create<moving>(1.0f * i, i);
+    world.create<tagged>(i, 'a');
+    world.create<still>(1.0f);
+  }
+  int chunks = 0;
+  std::size_t rows = 0;
+  world.for_each_chunk<int>([&](int* ints, std::size_t n) {
+    chunks++;
+    rows += n;
+    ASSERT_EQ(std::accumulate(ints, ints + n, 0), 45);
+  });
+  ASSERT_EQ(chunks, 2);
+  ASSERT_EQ(rows, 20);
+  world.for_each<int, float>([](int& i, float& f) { f += i; });
+  float total = 0;
+  world.for_each<float>([&total](float& f) { total += f; });
+  ASSERT_EQ(total, 2 * 45 + 10);
+}
+
+TEST_F(UnpackTest, MatrixViewSeesHomogeneousColumns) {
+  std::vector<unpack<tuple<double, double, double>>> v;
+  for (int i = 0; i < 300; i++) {
+    v.push_back(tuple<double, double, double>(3 * i, 4 * i, 0));
+  }
+  auto m = as_matrix(v);
+  static_assert(decltype(m)::cols() == 3, "");
+  ASSERT_EQ(m.rows(), 300);
+  ASSERT_EQ(m(10, 1), 40);
+  m(10, 2) = 7;
+  ASSERT_EQ(std::get<2>(v[10]), 7);
+  m(10, 2) = 0;
+  std::vector<double> norms(v.size());
+  matrix_row_norms(as_matrix(static_cast<const decltype(v)&>(v)), norms.data());
+  ASSERT_EQ(norms[0], 0);
+  ASSERT_EQ(norms[299], 5 * 299);
+  std::vector<double> rows(3 * v.size());
+  matrix_transpose(m, rows.data());
+  ASSERT_EQ(rows[3 * 200], 600);
+  ASSERT_EQ(rows[3 * 200 + 1], 800);
+  ASSERT_EQ(m.block(200, 10)(0, 1), 800);
+}
+
+TEST_F(UnpackTest, MatrixMultiplyAcrossColumns) {
+  std::vector<unpack<tuple<float, float, float>>> a;
+  for (int i = 0; i < 200; i++) {
+    a.push_back(tuple<float, float, float>(i, 1, 2));
+  }
+  const float b[] = { 1, 0, 0, 1, 1, 1 };
+  std::vector<unpack<tuple<float, float>>> c(a.size());
+  matrix_multiply(as_matrix(a), b, as_matrix(c));
+  ASSERT_EQ(std::get<0>(c[150]), 152);
+  ASSERT_EQ(std::get<1>(c[150]), 3);
+  std::vector<unpack<tuple<float, float>>> d(10);
+  ASSERT_THROW(matrix_multiply(as_matrix(a), b, as_matrix(d)), std::invalid_argument);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();